@@ -0,0 +1,159 @@
+#include <iostream>
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include "BinaryFuseFilter.hpp"
+
+static uint64_t fuse_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/* Method Definitions for 'BinaryFuseFilter' class */
+BinaryFuseFilter::BinaryFuseFilter(size_t set_size, size_t fingerprint_bytes, uint64_t seed)
+    : width(fingerprint_bytes), seed(seed) {
+    if (width == 0 || width > FUSE_MAX_FINGERPRINT_BYTES) {
+        throw std::invalid_argument("BinaryFuseFilter: fingerprint bytes must be 1.." + std::to_string(FUSE_MAX_FINGERPRINT_BYTES));
+    }
+
+    /* Sizing from Graf & Lemire, "Binary Fuse Filters" (arity 3) */
+    const uint32_t arity = 3;
+    double size = static_cast<double>(std::max<size_t>(set_size, 2));
+    segment_length = set_size == 0 ? 4 : 1u << static_cast<int>(std::floor(std::log(size) / std::log(3.33) + 2.25));
+    /* The paper retries with a new seed when peeling fails; the seed here is shared by
+       every party, so a failure would drop elements for good. Peeling mostly fails on two
+       elements drawing the same three cells, which is likely once n^2 / 2 nears
+       segment_count_length * segment_length^2, so segments grow until that expected
+       count is below FUSE_MAX_TRIPLE_COLLISIONS, with a floor for the smallest sets. */
+    segment_length = std::max<uint32_t>(segment_length, 256);
+    double size_factor = std::max(1.125, 0.875 + 0.25 * std::log(1000000.0) / std::log(size));
+    uint32_t capacity = static_cast<uint32_t>(std::round(size * size_factor));
+    for (;;) {
+        segment_length_mask = segment_length - 1;
+        uint32_t init_segment_count = (capacity + segment_length - 1) / segment_length;
+        init_segment_count = init_segment_count > arity - 1 ? init_segment_count - (arity - 1) : 1;
+        array_length = (init_segment_count + arity - 1) * segment_length;
+        segment_count = (array_length + segment_length - 1) / segment_length;
+        segment_count = segment_count <= arity - 1 ? 1 : segment_count - (arity - 1);
+        array_length = (segment_count + arity - 1) * segment_length;
+        segment_count_length = segment_count * segment_length;
+
+        double collisions = size * (size - 1) / 2.0
+            / (static_cast<double>(segment_count_length) * segment_length * segment_length);
+        if (collisions <= FUSE_MAX_TRIPLE_COLLISIONS || segment_length >= FUSE_MAX_SEGMENT_LENGTH) {
+            break;
+        }
+        segment_length <<= 1;
+    }
+}
+
+size_t BinaryFuseFilter::cell_count() const {
+    return array_length;
+}
+
+size_t BinaryFuseFilter::fingerprint_bytes() const {
+    return width;
+}
+
+size_t BinaryFuseFilter::byte_size() const {
+    return static_cast<size_t>(array_length) * width;
+}
+
+void BinaryFuseFilter::positions(const std::array<uint64_t, 2>& digest, std::array<size_t, 3>& out) const {
+    /* One cell in each of three consecutive segments */
+    uint64_t h = fuse_mix(digest[0] ^ seed);
+    uint64_t h0 = static_cast<uint64_t>((static_cast<unsigned __int128>(h) * segment_count_length) >> 64);
+    uint64_t h1 = h0 + segment_length;
+    uint64_t h2 = h1 + segment_length;
+    h1 ^= (h >> 18) & segment_length_mask;
+    h2 ^= h & segment_length_mask;
+    out = {static_cast<size_t>(h0), static_cast<size_t>(h1), static_cast<size_t>(h2)};
+}
+
+std::vector<size_t> BinaryFuseFilter::positions(const std::array<uint64_t, 2>& digest) const {
+    std::array<size_t, 3> cells;
+    positions(digest, cells);
+    return std::vector<size_t>(cells.begin(), cells.end());
+}
+
+void BinaryFuseFilter::fingerprint(const std::array<uint64_t, 2>& digest, uint8_t* out) const {
+    uint64_t fp = fuse_mix(digest[1] ^ seed);
+    std::memcpy(out, &fp, width);
+}
+
+size_t BinaryFuseFilter::encode(const std::vector<std::array<uint64_t, 2>>& digests, uint8_t* cells,
+                                bool with_fingerprints) const {
+    const size_t n = digests.size();
+    std::vector<std::array<size_t, 3>> element_cells(n);
+    std::vector<uint32_t> counts(array_length, 0);
+    std::vector<uint64_t> element_xor(array_length, 0); // XOR of the element indices in a cell
+
+    for (size_t e = 0; e < n; ++e) {
+        positions(digests[e], element_cells[e]);
+        for (size_t cell : element_cells[e]) {
+            counts[cell]++;
+            element_xor[cell] ^= e;
+        }
+    }
+
+    /* Peel: a cell with one element left determines that element; remove it and repeat */
+    std::vector<size_t> queue;
+    for (size_t cell = 0; cell < array_length; ++cell) {
+        if (counts[cell] == 1) queue.push_back(cell);
+    }
+    std::vector<std::pair<size_t, size_t>> order; // (element, cell it owns)
+    order.reserve(n);
+    while (!queue.empty()) {
+        size_t cell = queue.back();
+        queue.pop_back();
+        if (counts[cell] != 1) continue;
+        size_t e = element_xor[cell];
+        order.emplace_back(e, cell);
+        for (size_t other : element_cells[e]) {
+            counts[other]--;
+            element_xor[other] ^= e;
+            if (counts[other] == 1) queue.push_back(other);
+        }
+    }
+
+    /* Cells owned by no element keep random bytes, so non-members look random too */
+    std::mt19937_64 rng(std::random_device{}());
+    for (size_t i = 0; i < byte_size(); i += sizeof(uint64_t)) {
+        uint64_t r = rng();
+        std::memcpy(cells + i, &r, std::min(sizeof(r), byte_size() - i));
+    }
+
+    /* Assign in reverse peel order: an owned cell is never read by an element assigned later */
+    std::array<uint8_t, FUSE_MAX_FINGERPRINT_BYTES> value;
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        size_t e = it->first;
+        size_t owned = it->second;
+        if (with_fingerprints) {
+            fingerprint(digests[e], value.data());
+        } else {
+            std::fill_n(value.begin(), width, 0);
+        }
+        for (size_t cell : element_cells[e]) {
+            if (cell == owned) continue;
+            for (size_t j = 0; j < width; ++j) value[j] ^= cells[cell * width + j];
+        }
+        std::memcpy(cells + owned * width, value.data(), width);
+    }
+
+    size_t unplaced = n - order.size();
+    if (unplaced > 0) {
+        std::cout << "BinaryFuseFilter::encode(): " << unplaced << " of " << n
+                  << " elements could not be placed (shared seed has no peeling order)\n";
+    }
+    return unplaced;
+}
+
+double BinaryFuseFilter::false_positive_rate(size_t fingerprint_bytes) {
+    return std::ldexp(1.0, -8 * static_cast<int>(fingerprint_bytes));
+}
@@ -0,0 +1,56 @@
+#ifndef BINARY_FUSE_FILTER_HPP
+#define BINARY_FUSE_FILTER_HPP
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+constexpr size_t FUSE_MAX_FINGERPRINT_BYTES = sizeof(uint64_t);
+// Expected number of element pairs sharing all three cells that the sizing allows
+constexpr double FUSE_MAX_TRIPLE_COLLISIONS = 1e-4;
+constexpr uint32_t FUSE_MAX_SEGMENT_LENGTH = 1u << 20;
+
+// Binary fuse filter (3-wise) over 128-bit element digests. Every element maps to three
+// cells of fingerprint_bytes each, and an encoded filter XORs to the element's fingerprint
+// (or to zero) over those cells. The geometry depends only on the expected set size and
+// the seed, so all parties agree on the cell positions of an element.
+class BinaryFuseFilter {
+public:
+    BinaryFuseFilter(size_t set_size, size_t fingerprint_bytes, uint64_t seed);
+
+    size_t cell_count() const;
+    size_t fingerprint_bytes() const;
+    size_t byte_size() const;
+
+    void positions(const std::array<uint64_t, 2>& digest, std::array<size_t, 3>& out) const;
+    std::vector<size_t> positions(const std::array<uint64_t, 2>& digest) const;
+    void fingerprint(const std::array<uint64_t, 2>& digest, uint8_t* out) const;
+
+    // Fill 'cells' (byte_size() bytes) so each element's three cells XOR to its fingerprint,
+    // or to zero when with_fingerprints is false. Cells no element pins down are random.
+    // Returns the number of elements that could not be placed (they will not match).
+    size_t encode(const std::vector<std::array<uint64_t, 2>>& digests, uint8_t* cells,
+                  bool with_fingerprints = true) const;
+
+    // Chance that a non-member's three cells XOR to the expected value
+    static double false_positive_rate(size_t fingerprint_bytes);
+
+private:
+    size_t width;
+    uint64_t seed;
+    uint32_t segment_length;
+    uint32_t segment_length_mask;
+    uint32_t segment_count;
+    uint32_t segment_count_length;
+    uint32_t array_length;
+};
+
+// Whether sender 'id' of 'party_count' parties encodes fingerprints. Senders 2.. always do;
+// the querier (party 1) does only if that evens out the count, so the fingerprints of an
+// element every sender holds cancel and its cells XOR to zero in the aggregate
+inline bool fuse_encodes_fingerprints(size_t id, size_t party_count) {
+    return id != 1 || (party_count - 2) % 2 == 1;
+}
+
+#endif // BINARY_FUSE_FILTER_HPP
@@ -0,0 +1,37 @@
+#include <algorithm>
+#include "BufferPool.hpp"
+
+/* Method Definitions for 'BufferPool' class */
+BufferPool::BufferPool(size_t max_buffers) : max_buffers(max_buffers) {}
+
+std::vector<uint8_t> BufferPool::acquire() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (idle.empty()) {
+        return {};
+    }
+    std::vector<uint8_t> buffer = std::move(idle.back());
+    idle.pop_back();
+    buffer.clear();
+    return buffer;
+}
+
+void BufferPool::release(std::vector<uint8_t>&& buffer) {
+    if (buffer.capacity() == 0) return;
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (idle.size() < max_buffers) {
+        idle.push_back(std::move(buffer));
+    }
+    buffer = std::vector<uint8_t>();
+}
+
+size_t BufferPool::idle_count() const {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    return idle.size();
+}
+
+size_t BufferPool::idle_bytes() const {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    size_t bytes = 0;
+    for (const auto& buffer : idle) bytes += buffer.capacity();
+    return bytes;
+}
@@ -0,0 +1,28 @@
+#ifndef BUFFER_POOL_HPP
+#define BUFFER_POOL_HPP
+
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// Recycles byte buffers so their capacity is reused instead of freed and reallocated.
+// Holds at most 'max_buffers' idle buffers; extra ones are released. Thread-safe.
+class BufferPool {
+public:
+    explicit BufferPool(size_t max_buffers = 8);
+
+    // An empty buffer, with the capacity of a recycled one when available
+    std::vector<uint8_t> acquire();
+    void release(std::vector<uint8_t>&& buffer);
+
+    size_t idle_count() const;
+    size_t idle_bytes() const;
+
+private:
+    size_t max_buffers;
+    std::vector<std::vector<uint8_t>> idle;
+    mutable std::mutex pool_mutex;
+};
+
+#endif // BUFFER_POOL_HPP
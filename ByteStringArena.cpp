@@ -0,0 +1,66 @@
+#include <cstring>
+#include <stdexcept>
+#include "ByteStringArena.hpp"
+
+/* Method Definitions for 'ByteStringArena' class */
+ByteStringArena::ByteStringArena() : offsets(1, 0) {}
+
+void ByteStringArena::reserve(size_t key_count, size_t byte_count) {
+    offsets.reserve(key_count + 1);
+    bytes.reserve(byte_count);
+}
+
+void ByteStringArena::push_back(const uint8_t* data, size_t length) {
+    bytes.insert(bytes.end(), data, data + length);
+    offsets.push_back(bytes.size());
+}
+
+void ByteStringArena::push_back(std::string_view key) {
+    push_back(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+}
+
+size_t ByteStringArena::size() const {
+    return offsets.size() - 1;
+}
+
+size_t ByteStringArena::byte_size() const {
+    return bytes.size();
+}
+
+std::string_view ByteStringArena::operator[](size_t index) const {
+    if (index >= size()) {
+        throw std::out_of_range("ByteStringArena: invalid index " + std::to_string(index));
+    }
+    return std::string_view(reinterpret_cast<const char*>(bytes.data()) + offsets[index],
+                            offsets[index + 1] - offsets[index]);
+}
+
+void ByteStringArena::fingerprint_all(const FingerprintKey& key, uint8_t* out, size_t out_len) const {
+    /* Keyed init only sets up the key and an empty chunk, so it is cheap to redo per key */
+    blake3_hasher hasher;
+    for (size_t i = 0; i < size(); ++i) {
+        blake3_hasher_init_keyed(&hasher, key.data());
+        blake3_hasher_update(&hasher, bytes.data() + offsets[i], offsets[i + 1] - offsets[i]);
+        blake3_hasher_finalize(&hasher, out + i * out_len, out_len);
+    }
+}
+
+std::vector<uint64_t> ByteStringArena::fingerprints64(const FingerprintKey& key) const {
+    std::vector<uint64_t> fingerprints(size());
+    fingerprint_all(key, reinterpret_cast<uint8_t*>(fingerprints.data()), sizeof(uint64_t));
+    return fingerprints;
+}
+
+std::vector<std::array<uint64_t, 2>> ByteStringArena::fingerprints128(const FingerprintKey& key) const {
+    std::vector<std::array<uint64_t, 2>> fingerprints(size());
+    fingerprint_all(key, reinterpret_cast<uint8_t*>(fingerprints.data()), sizeof(std::array<uint64_t, 2>));
+    return fingerprints;
+}
+
+FingerprintKey ByteStringArena::derive_key(const std::string& context) {
+    FingerprintKey key;
+    blake3_hasher hasher;
+    blake3_hasher_init_derive_key(&hasher, context.c_str());
+    blake3_hasher_finalize(&hasher, key.data(), key.size());
+    return key;
+}
@@ -0,0 +1,41 @@
+#ifndef BYTE_STRING_ARENA_HPP
+#define BYTE_STRING_ARENA_HPP
+
+#include <vector>
+#include <array>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include "blake3.h"
+
+using FingerprintKey = std::array<uint8_t, BLAKE3_KEY_LEN>;
+
+// Variable-length byte-string keys stored back to back in one buffer; key i spans
+// bytes [offsets[i], offsets[i+1]). No per-key allocation.
+class ByteStringArena {
+public:
+    ByteStringArena();
+
+    void reserve(size_t key_count, size_t byte_count);
+    void push_back(const uint8_t* data, size_t length);
+    void push_back(std::string_view key);
+
+    size_t size() const;
+    size_t byte_size() const;
+    std::string_view operator[](size_t index) const;
+
+    // Keyed BLAKE3 over every key in one pass over the arena
+    std::vector<uint64_t> fingerprints64(const FingerprintKey& key) const;
+    std::vector<std::array<uint64_t, 2>> fingerprints128(const FingerprintKey& key) const;
+
+    // Session key shared by all parties, derived from a context string
+    static FingerprintKey derive_key(const std::string& context);
+
+private:
+    std::vector<uint8_t> bytes;
+    std::vector<size_t> offsets;
+
+    void fingerprint_all(const FingerprintKey& key, uint8_t* out, size_t out_len) const;
+};
+
+#endif // BYTE_STRING_ARENA_HPP
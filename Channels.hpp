@@ -17,14 +17,14 @@ class Channels {
         std::cout << "Channels constructor called" << std::endl;
         // Debugging checkpoints
         std::cout << "Before allocating buffers" << std::endl;
-        network.bucket_size(100); //.resize(1024); // If this crashes, buffer is corrupted
+        reserve_network(); //.resize(1024); // If this crashes, buffer is corrupted
         std::cout << "After allocating buffers" << std::endl;
 
         std::cout << "Channels constructor finished" << std::endl;
     }
 
     Channels(double latency_seconds, double bytes_per_sec) : latency_seconds(latency_seconds), bytes_per_sec(bytes_per_sec) {
-        network.bucket_size(100);
+        reserve_network();
     }
 
     void simulate_network(const std::vector<uint8_t>& data);
@@ -42,6 +42,13 @@ class Channels {
 
     // Mutex for thread safety
     static std::mutex network_mutex;
+
+    // Meshes of different lanes and sessions build their Channels at the same time, so the
+    // shared map is only touched under the mutex
+    static void reserve_network() {
+        std::lock_guard<std::mutex> lock(network_mutex);
+        network.reserve(100);
+    }
     double latency_seconds;
     double bytes_per_sec;
 };
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <future>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CorrelatedSeeds.hpp"
+#include "TaskRuntime.hpp"
+
+/* Method Definitions for 'CorrelatedSeeds' class */
+CorrelatedSeeds::CorrelatedSeeds(PairKeys pair_keys, size_t party,
+                                 size_t first_contributor, size_t contributor_count, size_t seed_count)
+    : pair_keys(std::move(pair_keys)), party(party), first(first_contributor), count(contributor_count),
+      seed_count(seed_count) {}
+
+std::vector<PairKeys> CorrelatedSeeds::deal_pair_keys(size_t first_contributor, size_t contributor_count) {
+    std::vector<PairKeys> keys(contributor_count);
+    for (size_t a = 0; a < contributor_count; ++a) {
+        for (size_t b = a + 1; b < contributor_count; ++b) {
+            SeedKey key = random_key();
+            keys[a][first_contributor + b] = key;
+            keys[b][first_contributor + a] = key;
+        }
+    }
+    return keys;
+}
+
+SeedKey CorrelatedSeeds::random_key() {
+    SeedKey key;
+    std::random_device rd;
+    for (size_t i = 0; i < key.size(); i += sizeof(uint32_t)) {
+        uint32_t r = rd();
+        std::copy_n(reinterpret_cast<const uint8_t*>(&r), sizeof(r), key.data() + i);
+    }
+    return key;
+}
+
+size_t CorrelatedSeeds::size() const {
+    return seed_count;
+}
+
+size_t CorrelatedSeeds::partner(size_t round) const {
+    if (count < 2 || party < first || party >= first + count) return party;
+
+    /* Circle method over an even number of slots; with an odd count the last slot is empty.
+       Slot slots-1 stays fixed and meets r in round r; every other slot a meets 2r - a. */
+    const size_t slots = count + count % 2;
+    const size_t r = round % (slots - 1);
+    const size_t a = party - first;
+    size_t b;
+    if (a == slots - 1) {
+        b = r;
+    } else if (a == r) {
+        b = slots - 1;
+    } else {
+        b = (2 * r + (slots - 1) - a) % (slots - 1);
+    }
+    return b < count ? first + b : party;
+}
+
+const SeedKey& CorrelatedSeeds::pair_key(size_t other) const {
+    auto key = pair_keys.find(other);
+    if (key == pair_keys.end()) {
+        throw std::logic_error("CorrelatedSeeds::pair_key: party " + std::to_string(party) +
+                               " holds no key for party " + std::to_string(other));
+    }
+    return key->second;
+}
+
+bool CorrelatedSeeds::seed(size_t index, std::array<uint8_t, RAND_SECRET_SIZE>& out) const {
+    size_t other = partner(index);
+    if (other == party) return false;
+
+    const SeedKey& key = pair_key(other);
+    uint64_t counter = index;
+    blake3_hasher hasher;
+    blake3_hasher_init_keyed(&hasher, key.data());
+    blake3_hasher_update(&hasher, &counter, sizeof(counter));
+    blake3_hasher_finalize(&hasher, out.data(), out.size());
+    return true;
+}
+
+SimdBytes CorrelatedSeeds::expand(size_t byte_count) const {
+    return expand_rounds(byte_count, nullptr);
+}
+
+SimdBytes CorrelatedSeeds::expand_pairs(const std::vector<size_t>& partners, size_t byte_count) const {
+    std::vector<size_t> sorted(partners);
+    std::sort(sorted.begin(), sorted.end());
+    return expand_rounds(byte_count, &sorted);
+}
+
+SimdBytes CorrelatedSeeds::expand_rounds(size_t byte_count, const std::vector<size_t>* partners) const {
+    /* Seeds are derived as the workers reach them; none is kept once expanded */
+    const size_t workers = std::min<size_t>(std::max<size_t>(1, std::thread::hardware_concurrency()),
+                                            std::max<size_t>(1, seed_count));
+    auto expand_range = [this, byte_count, partners](size_t begin, size_t end) {
+        SimdBytes partial(byte_count, 0);
+        std::vector<uint8_t> stream(byte_count);
+        std::array<uint8_t, RAND_SECRET_SIZE> s;
+        blake3_hasher hasher;
+        for (size_t t = begin; t < end; ++t) {
+            if (partners && !std::binary_search(partners->begin(), partners->end(), partner(t))) continue;
+            if (!seed(t, s)) continue;
+            blake3_hasher_init(&hasher);
+            blake3_hasher_update(&hasher, s.data(), s.size());
+            blake3_hasher_finalize(&hasher, stream.data(), byte_count);
+            xor_bytes(partial.bytes.data(), stream.data(), byte_count);
+        }
+        return partial;
+    };
+
+    std::vector<std::future<SimdBytes>> partials;
+    const size_t per_worker = (seed_count + workers - 1) / workers;
+    for (size_t w = 0; w < workers; ++w) {
+        size_t begin = std::min(w * per_worker, seed_count);
+        size_t end = std::min(begin + per_worker, seed_count);
+        partials.push_back(compute_pool().enqueue(expand_range, begin, end));
+    }
+    SimdBytes share(byte_count, 0);
+    for (auto& partial : partials) {
+        SimdBytes bytes = partial.get();
+        xor_bytes(share.bytes.data(), bytes.bytes.data(), byte_count);
+    }
+    return share;
+}
@@ -0,0 +1,56 @@
+#ifndef CORRELATED_SEEDS_HPP
+#define CORRELATED_SEEDS_HPP
+
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "blake3.h"
+#include "secret_sharing_simd.hpp"
+
+using SeedKey = std::array<uint8_t, BLAKE3_KEY_LEN>;
+using PairKeys = std::unordered_map<size_t, SeedKey>;  // Partner -> key shared with it
+
+// Zero-sharing seeds derived on demand. The contributors (parties first .. first+count-1)
+// are paired round-robin; in round t each party derives seed t from the key it shares with
+// its round-t partner, so both hold the same seed and the XOR of all contributors' zero
+// shares is zero. With an odd count one party sits each round out. A party holds only its
+// own count-1 pair keys, so it cannot derive any other party's zero share; seeds are
+// recomputed from the keys when needed.
+class CorrelatedSeeds {
+public:
+    CorrelatedSeeds() = default;  // No seeds (the server)
+    CorrelatedSeeds(PairKeys pair_keys, size_t party,
+                    size_t first_contributor, size_t contributor_count, size_t seed_count);
+
+    // Random key for every pair of contributors; element i holds contributor first+i's keys.
+    // Stands in for a pairwise key agreement: each key is handed to its two parties only
+    static std::vector<PairKeys> deal_pair_keys(size_t first_contributor, size_t contributor_count);
+    static SeedKey random_key();
+
+    size_t size() const;
+    // Round-t partner, or 'party' itself when it sits the round out
+    size_t partner(size_t round) const;
+    // False when the party sits round 'index' out
+    bool seed(size_t index, std::array<uint8_t, RAND_SECRET_SIZE>& out) const;
+
+    // XOR of the BLAKE3 expansions of every seed, computed on the compute pool
+    SimdBytes expand(size_t byte_count) const;
+    // Only the seeds shared with 'partners': the part of the zero share that no longer
+    // cancels when those parties drop out of the round (their correction share)
+    SimdBytes expand_pairs(const std::vector<size_t>& partners, size_t byte_count) const;
+
+private:
+    PairKeys pair_keys;
+    size_t party = 0;
+    size_t first = 0;
+    size_t count = 0;
+    size_t seed_count = 0;
+
+    const SeedKey& pair_key(size_t other) const;
+    /* Rounds whose partner is in 'partners' (sorted), or every round when null */
+    SimdBytes expand_rounds(size_t byte_count, const std::vector<size_t>* partners) const;
+};
+
+#endif // CORRELATED_SEEDS_HPP
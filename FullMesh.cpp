@@ -6,10 +6,8 @@
 #include "Stats.hpp"
 using namespace std::chrono_literals;
 
-extern Stats g_stats;
 // Define static members
-std::unordered_map<size_t, std::unordered_map<size_t, std::queue<std::vector<uint8_t>>>> FullMesh::network;
-std::mutex FullMesh::network_mutex;
+BufferPool FullMesh::buffer_pool;
 
 // Constructor
 FullMesh::FullMesh(double latency_seconds, double bytes_per_sec)
@@ -17,11 +15,48 @@ FullMesh::FullMesh(double latency_seconds, double bytes_per_sec)
         initialize_channels();
     }
 
-FullMesh::FullMesh(double latency_seconds, double bytes_per_sec, size_t party_count /*, Stats & pstats*/)
-    : latency_seconds(latency_seconds), bytes_per_sec(bytes_per_sec), party_count(party_count) /*, stats(pstats)*/ {
+FullMesh::FullMesh(double latency_seconds, double bytes_per_sec, size_t party_count, Stats& pstats, size_t lane)
+    : latency_seconds(latency_seconds), bytes_per_sec(bytes_per_sec), party_count(party_count), lane(lane), stats(&pstats) {
         initialize_channels();
     }
 
+std::unique_ptr<FullMesh> FullMesh::lane_view(size_t lane) const {
+    auto view = std::make_unique<FullMesh>(latency_seconds, bytes_per_sec, party_count, *stats, lane);
+    view->queues = queues;
+    view->speed_model = speed_model;
+    return view;
+}
+
+void FullMesh::set_speed_model(std::shared_ptr<const SpeedModel> model) {
+    speed_model = std::move(model);
+}
+
+void FullMesh::mark_active(size_t party_id) {
+    if (!speed_model) return;
+    std::lock_guard<std::mutex> lock(queues->mutex);
+    queues->last_active[slot(party_id)] = std::chrono::steady_clock::now();
+}
+
+void FullMesh::charge_compute(size_t sender_id) {
+    const double slowdown = speed_model->party(sender_id).slowdown;
+    if (slowdown <= 1.0) return;
+
+    std::chrono::steady_clock::time_point since;
+    {
+        std::lock_guard<std::mutex> lock(queues->mutex);
+        auto last = queues->last_active.find(slot(sender_id));
+        if (last == queues->last_active.end()) return;
+        since = last->second;
+    }
+    /* Only the host time since the party's last message counts; waiting on others is not compute */
+    std::this_thread::sleep_for((slowdown - 1.0) * (std::chrono::steady_clock::now() - since));
+}
+
+size_t FullMesh::slot(size_t party_id) const {
+    /* Lane in the high half; party ids (including shard and daemon endpoints) stay far below */
+    return (lane << 32) | party_id;
+}
+
 FullMesh::FullMesh(size_t party_count) : party_count(party_count) {
     channels.reserve(party_count);
     for (size_t i = 0; i < party_count; ++i) {
@@ -45,32 +80,71 @@ FullMesh& FullMesh::operator=(FullMesh&& other) noexcept {
     if (this != &other) {
         party_count = other.party_count;
         channels = std::move(other.channels);
+        queues = other.queues;
+        stats = other.stats;
+        speed_model = std::move(other.speed_model);
     }
     return *this;
 }
 
-// Send a message to a recipient party
-void FullMesh::send(size_t sender_id, size_t recipient_id, const std::vector<uint8_t>& data) {
-    std::lock_guard<std::mutex> lock(network_mutex);
+/* Latency and bandwidth are simulated on the sender's thread, outside the network lock,
+   so concurrent senders overlap instead of serializing on the mutex */
+void FullMesh::simulate_transfer(size_t sender_id, size_t recipient_id, size_t byte_count, bool charge_latency) {
+    double latency = latency_seconds;
+    double bytes_per_sec = this->bytes_per_sec;
+    if (speed_model) {
+        charge_compute(sender_id);
+        latency = speed_model->link_latency(sender_id, recipient_id);
+        bytes_per_sec = speed_model->link_bytes_per_sec(sender_id, recipient_id);
+    }
 
     // Simulate latency
-    if (latency_seconds > 0.0) {
+    if (charge_latency && latency > 0.0) {
         //std::this_thread::sleep_for(std::chrono::duration<double>(latency_seconds));
-        std::this_thread::sleep_for(latency_seconds*1ms);
+        std::this_thread::sleep_for(latency*1ms);
     }
 
     // Simulate bandwidth restriction
     if (bytes_per_sec > 0.0) {
-        auto transmission_time = (data.size() / bytes_per_sec)*1s;
+        auto transmission_time = (byte_count / bytes_per_sec)*1s;
         //std::this_thread::sleep_for(std::chrono::duration<double>(transmission_time));
         std::this_thread::sleep_for(transmission_time);
     }
+}
+
+void FullMesh::enqueue(size_t sender_id, size_t recipient_id, const std::vector<uint8_t>& data) {
+    /* Copy into recycled storage before taking the lock */
+    std::vector<uint8_t> message = buffer_pool.acquire();
+    message.assign(data.begin(), data.end());
+
+    {
+        std::lock_guard<std::mutex> lock(queues->mutex);
+
+        // Push the data into the recipient’s queue
+        queues->network[slot(recipient_id)][slot(sender_id)].push(std::move(message));
+        if (speed_model) {
+            queues->last_active[slot(sender_id)] = std::chrono::steady_clock::now();
+        }
+    }
+    queues->cv.notify_all();
+}
 
-    // Push the data into the recipient’s queue
-    network[recipient_id][sender_id].push(data);
+// Send a message to a recipient party
+void FullMesh::send(size_t sender_id, size_t recipient_id, const std::vector<uint8_t>& data) {
+    simulate_transfer(sender_id, recipient_id, data.size(), true);
+    enqueue(sender_id, recipient_id, data);
+}
+
+void FullMesh::send_stream_chunk(size_t sender_id, size_t recipient_id, const std::vector<uint8_t>& data, bool first_chunk) {
+    simulate_transfer(sender_id, recipient_id, data.size(), first_chunk);
+    enqueue(sender_id, recipient_id, data);
 }
 
 void FullMesh::send(size_t sender_id, size_t recipient_id, const std::vector<std::vector<size_t>>& data) {
+    send(sender_id, recipient_id, encode_index_patterns(data));
+}
+
+std::vector<uint8_t> FullMesh::encode_index_patterns(const std::vector<std::vector<size_t>>& data) {
     std::ostringstream oss;
     size_t outer_size = data.size();
     oss.write(reinterpret_cast<const char*>(&outer_size), sizeof(size_t));
@@ -85,7 +159,7 @@ void FullMesh::send(size_t sender_id, size_t recipient_id, const std::vector<std
     }
 
     std::string serialized = oss.str();
-    send(sender_id, recipient_id, std::vector<uint8_t>(serialized.begin(), serialized.end()));
+    return std::vector<uint8_t>(serialized.begin(), serialized.end());
 }
 
 
@@ -104,33 +178,17 @@ void FullMesh::send(size_t sender_id, size_t recipient_id, const std::vector<boo
 
 // Receive a message from a sender party
 std::vector<uint8_t> FullMesh::receive(size_t receiver_id, size_t sender_id) {
-
-    auto start_time = std::chrono::steady_clock::now();
-    /* Wait till data is available  */
-    while (!can_receive(receiver_id, sender_id)) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
-    auto end_time = std::chrono::steady_clock::now();
-    g_stats.log_duration(Stats::OPS::COMPUTE_BREAKDOWN_WAITTIME, receiver_id, start_time, end_time);
-
-    std::lock_guard<std::mutex> lock(network_mutex);
-
-    auto& queue = network[receiver_id][sender_id];
-
-    if (queue.empty()) {
-        throw std::runtime_error("No messages from sender " + std::to_string(sender_id));
-    }
-
-    std::vector<uint8_t> message = queue.front();
-    queue.pop();
-    g_stats.log_msg_complexity(sender_id, 1, message.size()); // Log message complexity
-    return message;
+    std::vector<size_t> sender_ids{sender_id};
+    size_t from = 0;
+    return receive_any(receiver_id, sender_ids, from);
 }
 
 void FullMesh::receive(size_t receiver_id, size_t sender_id, std::vector<std::vector<size_t>>& data) {
-    std::vector<uint8_t> raw_bytes;
-    raw_bytes = receive(receiver_id, sender_id);
+    data = decode_index_patterns(receive(receiver_id, sender_id));
+}
 
+std::vector<std::vector<size_t>> FullMesh::decode_index_patterns(const std::vector<uint8_t>& raw_bytes) {
+    std::vector<std::vector<size_t>> data;
     std::istringstream iss(std::string(raw_bytes.begin(), raw_bytes.end()));
     size_t outer_size = 0;
     iss.read(reinterpret_cast<char*>(&outer_size), sizeof(size_t));
@@ -145,6 +203,7 @@ void FullMesh::receive(size_t receiver_id, size_t sender_id, std::vector<std::ve
             iss.read(reinterpret_cast<char*>(&data[i][j]), sizeof(size_t));
         }
     }
+    return data;
 }
 
 void FullMesh::receive(size_t receiver_id, size_t sender_id, std::vector<bool>& data) {
@@ -158,8 +217,100 @@ void FullMesh::receive(size_t receiver_id, size_t sender_id, std::vector<bool>&
     }
 }
 
+bool FullMesh::pop_locked(size_t receiver_id, size_t sender_id, std::vector<uint8_t>& data) {
+    auto& queue = queues->network[slot(receiver_id)][slot(sender_id)];
+    if (queue.empty()) {
+        return false;
+    }
+
+    data = std::move(queue.front());
+    queue.pop();
+    stats->log_msg_complexity(sender_id, 1, data.size()); // Log message complexity
+    return true;
+}
+
+bool FullMesh::try_receive(size_t receiver_id, size_t sender_id, std::vector<uint8_t>& data) {
+    std::lock_guard<std::mutex> lock(queues->mutex);
+    return pop_locked(receiver_id, sender_id, data);
+}
+
+std::vector<uint8_t> FullMesh::receive_any(size_t receiver_id, const std::vector<size_t>& sender_ids, size_t& from) {
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<uint8_t> message;
+    /* Sleep until a send wakes us and one of the senders has data; checked under the lock */
+    std::unique_lock<std::mutex> lock(queues->mutex);
+    queues->cv.wait(lock, [&]() {
+        for (size_t sender_id : sender_ids) {
+            if (pop_locked(receiver_id, sender_id, message)) {
+                from = sender_id;
+                return true;
+            }
+        }
+        return false;
+    });
+    if (speed_model) {
+        queues->last_active[slot(receiver_id)] = std::chrono::steady_clock::now();
+    }
+    lock.unlock();
+    auto end_time = std::chrono::steady_clock::now();
+    stats->log_duration(Stats::OPS::COMPUTE_BREAKDOWN_WAITTIME, receiver_id, start_time, end_time);
+    return message;
+}
+
+void FullMesh::receive_into(size_t receiver_id, size_t sender_id, std::vector<uint8_t>& buffer) {
+    std::vector<size_t> sender_ids{sender_id};
+    receive_any_into(receiver_id, sender_ids, buffer);
+}
+
+size_t FullMesh::receive_any_into(size_t receiver_id, const std::vector<size_t>& sender_ids, std::vector<uint8_t>& buffer) {
+    size_t from = 0;
+    std::vector<uint8_t> message = receive_any(receiver_id, sender_ids, from);
+    recycle(std::move(buffer));
+    buffer = std::move(message);
+    return from;
+}
+
+bool FullMesh::receive_any_until(size_t receiver_id, const std::vector<size_t>& sender_ids,
+                                 std::chrono::steady_clock::time_point deadline, std::vector<uint8_t>& buffer, size_t& from) {
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<uint8_t> message;
+    std::unique_lock<std::mutex> lock(queues->mutex);
+    bool received = queues->cv.wait_until(lock, deadline, [&]() {
+        for (size_t sender_id : sender_ids) {
+            if (pop_locked(receiver_id, sender_id, message)) {
+                from = sender_id;
+                return true;
+            }
+        }
+        return false;
+    });
+    if (speed_model) {
+        queues->last_active[slot(receiver_id)] = std::chrono::steady_clock::now();
+    }
+    lock.unlock();
+    auto end_time = std::chrono::steady_clock::now();
+    stats->log_duration(Stats::OPS::COMPUTE_BREAKDOWN_WAITTIME, receiver_id, start_time, end_time);
+    if (received) {
+        recycle(std::move(buffer));
+        buffer = std::move(message);
+    }
+    return received;
+}
+
+void FullMesh::discard_pending() {
+    std::lock_guard<std::mutex> lock(queues->mutex);
+    for (auto it = queues->network.begin(); it != queues->network.end();) {
+        it = (it->first >> 32) == lane ? queues->network.erase(it) : std::next(it);
+    }
+}
+
+void FullMesh::recycle(std::vector<uint8_t>&& buffer) {
+    buffer_pool.release(std::move(buffer));
+}
+
 bool FullMesh::can_receive(size_t receiver_id, size_t sender_id) {
-    return !network[receiver_id][sender_id].empty();
+    std::lock_guard<std::mutex> lock(queues->mutex);
+    return !queues->network[slot(receiver_id)][slot(sender_id)].empty();
 }
 
 Channels& FullMesh::get_channels(size_t party_id) const {
@@ -5,11 +5,15 @@
 #include <queue>
 #include <unordered_map>
 #include <mutex>
+#include <condition_variable>
 #include <cstdint>
 #include <chrono>
 #include <thread>
+#include <memory>
 #include "Channels.hpp"
 #include "Stats.hpp"
+#include "BufferPool.hpp"
+#include "SpeedModel.hpp"
 
 class FullMesh {
 public:
@@ -21,7 +25,20 @@ public:
         return FullMesh(latency, bytes_per_sec);
     }
     
-    FullMesh(double latency_seconds, double bytes_per_sec, size_t party_count /*, Stats & stats*/);
+    // Every mesh built here gets its own message queues, so meshes of different sessions
+    // never contend on one lock; messages are counted in 'stats'
+    FullMesh(double latency_seconds, double bytes_per_sec, size_t party_count, Stats& stats = g_stats, size_t lane = 0);
+
+    // Same link model and queues on a separate lane: party ids in different lanes never
+    // see each other's messages, so independent protocol runs can overlap
+    std::unique_ptr<FullMesh> lane_view(size_t lane) const;
+
+    // Per-party compute slowdown and per-link latency/bandwidth in place of the uniform
+    // link model (null restores it). Lane views made afterwards share the model.
+    void set_speed_model(std::shared_ptr<const SpeedModel> model);
+    // Start of a party's local computation; a slow party's next send is held back by the
+    // extra time its computation since the last message would have taken
+    void mark_active(size_t party_id);
 
 
     /*FullMesh(std::vector<std::unique_ptr<Channels>>&& channels);*/
@@ -38,6 +55,8 @@ public:
 
     // Send a message to a specific party
     void send(size_t sender_id, size_t recipient_id, const std::vector<uint8_t>& data);
+    // One chunk of a streamed message: chunks are pipelined, so only the first pays the latency
+    void send_stream_chunk(size_t sender_id, size_t recipient_id, const std::vector<uint8_t>& data, bool first_chunk);
     void send(size_t sender_id, size_t recipient_id, const std::vector<std::vector<size_t>>& data);
     void send(size_t sender_id, size_t recipient_id, const std::vector<bool>& data);
 
@@ -46,7 +65,26 @@ public:
     void receive(size_t receiver_id, size_t sender_id, std::vector<std::vector<size_t>>& data);
     void receive(size_t receiver_id, size_t sender_id, std::vector<bool>& data);
 
+    // Non-blocking receive; false if nothing is queued
+    bool try_receive(size_t receiver_id, size_t sender_id, std::vector<uint8_t>& data);
+    // Blocks until one of 'sender_ids' has a message; returns it and sets 'from'
+    std::vector<uint8_t> receive_any(size_t receiver_id, const std::vector<size_t>& sender_ids, size_t& from);
+    // Move the next message into 'buffer' (no copy); the buffer's old storage goes to the pool
+    void receive_into(size_t receiver_id, size_t sender_id, std::vector<uint8_t>& buffer);
+    size_t receive_any_into(size_t receiver_id, const std::vector<size_t>& sender_ids, std::vector<uint8_t>& buffer);
+    // As receive_any_into(), but gives up at 'deadline'; returns false if nothing arrived by then
+    bool receive_any_until(size_t receiver_id, const std::vector<size_t>& sender_ids,
+                           std::chrono::steady_clock::time_point deadline, std::vector<uint8_t>& buffer, size_t& from);
+    // Drop every message still queued in this lane (late shares nobody will read)
+    void discard_pending();
+    // Hand a buffer back for later sends to reuse
+    void recycle(std::vector<uint8_t>&& buffer);
+
     bool can_receive(size_t receiver_id, size_t sender_id);
+
+    // Wire format of send(..., std::vector<std::vector<size_t>>), for callers that batch messages
+    static std::vector<uint8_t> encode_index_patterns(const std::vector<std::vector<size_t>>& data);
+    static std::vector<std::vector<size_t>> decode_index_patterns(const std::vector<uint8_t>& raw_bytes);
     
     // Returns a reference to the communication channels
     Channels& get_channels(size_t party_id) const;
@@ -56,14 +94,34 @@ private:
     double latency_seconds;
     double bytes_per_sec;
     size_t party_count;
+    size_t lane = 0;
     std::vector<std::unique_ptr<Channels>> channels;
 
-    // Static map to simulate a network (for testing without real networking)
-    static std::unordered_map<size_t, std::unordered_map<size_t, std::queue<std::vector<uint8_t>>>> network;
+    // In-memory network of one protocol instance (for testing without real networking)
+    struct MessageQueues {
+        std::unordered_map<size_t, std::unordered_map<size_t, std::queue<std::vector<uint8_t>>>> network;
+        // Mutex for thread safety
+        std::mutex mutex;
+        // Signalled on every enqueue; receivers block on it instead of polling
+        std::condition_variable cv;
+        // When each party last sent or received, for the compute slowdown
+        std::unordered_map<size_t, std::chrono::steady_clock::time_point> last_active;
+    };
+    std::shared_ptr<MessageQueues> queues = std::make_shared<MessageQueues>();
+
+    // Message storage recycled between receivers and senders, shared by every mesh
+    static BufferPool buffer_pool;
+    Stats* stats = &g_stats;
+    std::shared_ptr<const SpeedModel> speed_model;
 
-    // Mutex for thread safety
-    static std::mutex network_mutex;
-    //Stats stats;
+    void simulate_transfer(size_t sender_id, size_t recipient_id, size_t byte_count, bool charge_latency);
+    // Sleep off the sender's compute slowdown since it was last active
+    void charge_compute(size_t sender_id);
+    void enqueue(size_t sender_id, size_t recipient_id, const std::vector<uint8_t>& data);
+    // Queue key of a party id in this lane
+    size_t slot(size_t party_id) const;
+    // Pop the next message from one sender; queues->mutex must be held
+    bool pop_locked(size_t receiver_id, size_t sender_id, std::vector<uint8_t>& data);
     
         // Constructor with optional latency and bandwidth constraints
     FullMesh(double latency_seconds = 0.0, double bytes_per_sec = 0.0);
@@ -0,0 +1,113 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "MappedFile.hpp"
+
+static std::runtime_error mapped_file_error(const std::string& what, const std::string& path) {
+    return std::runtime_error("MappedFile: " + what + " '" + path + "': " + std::strerror(errno));
+}
+
+/* Method Definitions for 'MappedFile' class */
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : fd(std::exchange(other.fd, -1)), ptr(std::exchange(other.ptr, nullptr)), length(std::exchange(other.length, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        fd = std::exchange(other.fd, -1);
+        ptr = std::exchange(other.ptr, nullptr);
+        length = std::exchange(other.length, 0);
+    }
+    return *this;
+}
+
+MappedFile MappedFile::create(const std::string& path, size_t size) {
+    MappedFile file;
+    file.fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (file.fd < 0) {
+        throw mapped_file_error("cannot create", path);
+    }
+    if (::ftruncate(file.fd, static_cast<off_t>(size)) != 0) {
+        throw mapped_file_error("cannot resize", path);
+    }
+    file.length = size;
+    if (size > 0) {
+        void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file.fd, 0);
+        if (addr == MAP_FAILED) {
+            throw mapped_file_error("cannot map", path);
+        }
+        file.ptr = static_cast<uint8_t*>(addr);
+    }
+    return file;
+}
+
+MappedFile MappedFile::open_read(const std::string& path, bool random_access, bool populate) {
+    MappedFile file;
+    file.fd = ::open(path.c_str(), O_RDONLY);
+    if (file.fd < 0) {
+        throw mapped_file_error("cannot open", path);
+    }
+    struct stat st;
+    if (::fstat(file.fd, &st) != 0) {
+        throw mapped_file_error("cannot stat", path);
+    }
+    file.length = static_cast<size_t>(st.st_size);
+    if (file.length > 0) {
+        void* addr = ::mmap(nullptr, file.length, PROT_READ, MAP_PRIVATE | (populate ? MAP_POPULATE : 0), file.fd, 0);
+        if (addr == MAP_FAILED) {
+            throw mapped_file_error("cannot map", path);
+        }
+        /* Advice values are not flags; give them one at a time */
+        if (random_access) {
+            ::madvise(addr, file.length, MADV_RANDOM);
+        } else {
+            ::madvise(addr, file.length, MADV_SEQUENTIAL);
+            ::madvise(addr, file.length, MADV_WILLNEED);
+        }
+        file.ptr = static_cast<uint8_t*>(addr);
+    }
+    return file;
+}
+
+uint8_t* MappedFile::data() {
+    return ptr;
+}
+
+const uint8_t* MappedFile::data() const {
+    return ptr;
+}
+
+size_t MappedFile::size() const {
+    return length;
+}
+
+bool MappedFile::is_open() const {
+    return fd >= 0;
+}
+
+void MappedFile::sync() {
+    if (ptr != nullptr && ::msync(ptr, length, MS_SYNC) != 0) {
+        throw std::runtime_error(std::string("MappedFile: msync failed: ") + std::strerror(errno));
+    }
+}
+
+void MappedFile::close() {
+    if (ptr != nullptr) {
+        ::munmap(ptr, length);
+        ptr = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    length = 0;
+}
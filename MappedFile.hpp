@@ -0,0 +1,41 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Memory-mapped file, unmapped and closed on destruction. Move-only.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Create (or truncate) a file of 'size' bytes and map it read-write
+    static MappedFile create(const std::string& path, size_t size);
+    // Map an existing file read-only. 'random_access' switches the kernel hint from
+    // read-ahead to per-page faults; 'populate' faults the whole file in up front.
+    static MappedFile open_read(const std::string& path, bool random_access = false, bool populate = false);
+
+    uint8_t* data();
+    const uint8_t* data() const;
+    size_t size() const;
+    bool is_open() const;
+
+    // Flush a read-write mapping to disk
+    void sync();
+
+private:
+    int fd = -1;
+    uint8_t* ptr = nullptr;
+    size_t length = 0;
+
+    void close();
+};
+
+#endif // MAPPED_FILE_HPP
@@ -0,0 +1,216 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include "SessionHost.hpp"
+#include "approx_mpsi.hpp"
+#include "param_planner.hpp"
+#include "SpeedModel.hpp"
+
+/* Method Definitions for 'SessionHost' class */
+SessionHost::SessionHost(size_t memory_budget, size_t max_active, size_t party_workers)
+    : memory_budget(memory_budget), max_active(std::max<size_t>(1, max_active)) {
+    if (party_workers > 0) {
+        party_scheduler = std::make_unique<FairScheduler>(party_workers);
+    }
+}
+
+std::vector<Options> SessionHost::load_sessions(const std::string& path, const Options& base) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("SessionHost::load_sessions(): cannot open " + path);
+    }
+
+    /* Only parameters that every party reads through its own Options may differ per session */
+    using Setter = std::function<void(Options&, const std::string&)>;
+    auto size_field = [](size_t Options::*field) -> Setter {
+        return [field](Options& options, const std::string& value) { options.*field = std::stoull(value); };
+    };
+    auto double_field = [](double Options::*field) -> Setter {
+        return [field](Options& options, const std::string& value) { options.*field = std::stod(value); };
+    };
+    const std::unordered_map<std::string, Setter> setters = {
+        {"party-count", size_field(&Options::party_count)},
+        {"set-size", size_field(&Options::set_size)},
+        {"domain-size", size_field(&Options::domain_size)},
+        {"bin-count", size_field(&Options::bin_count)},
+        {"hash-count", size_field(&Options::hash_count)},
+        {"repetitions", size_field(&Options::repetitions)},
+        {"latency", double_field(&Options::latency)},
+        {"bytes-per-sec", double_field(&Options::bytes_per_sec)},
+        {"queriers", size_field(&Options::queriers)},
+        {"query-batches", size_field(&Options::query_batches)},
+        {"session-id", size_field(&Options::session_id)},
+        {"concurrent-repetitions", size_field(&Options::concurrent_repetitions)},
+        {"slowdown-sigma", double_field(&Options::slowdown_sigma)},
+        {"latency-sigma", double_field(&Options::latency_sigma)},
+        {"bandwidth-sigma", double_field(&Options::bandwidth_sigma)},
+        {"speed-seed", size_field(&Options::speed_seed)},
+    };
+
+    std::vector<Options> sessions;
+    std::string line;
+    for (size_t line_number = 1; std::getline(file, line); ++line_number) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string field;
+        Options options = base;
+        bool empty = true;
+        while (fields >> field) {
+            empty = false;
+            const size_t equals = field.find('=');
+            auto setter = setters.find(field.substr(0, equals));
+            if (equals == std::string::npos || setter == setters.end()) {
+                throw std::runtime_error("SessionHost::load_sessions(): line " + std::to_string(line_number) +
+                                         ": unsupported setting '" + field + "'");
+            }
+            try {
+                setter->second(options, field.substr(equals + 1));
+            } catch (const std::logic_error&) {
+                throw std::runtime_error("SessionHost::load_sessions(): line " + std::to_string(line_number) +
+                                         ": bad value in '" + field + "'");
+            }
+        }
+        if (empty) continue;
+
+        if (options.party_count < 3 || options.queriers == 0 || options.queriers >= options.party_count ||
+            options.query_batches == 0 || options.repetitions == 0 || options.set_size > options.domain_size) {
+            throw std::runtime_error("SessionHost::load_sessions(): line " + std::to_string(line_number) +
+                                     ": needs at least 3 parties, 1..party count - 1 queriers, non-zero batches and"
+                                     " repetitions, and a set size within the domain");
+        }
+        if (options.delta_churn > 0 && options.queriers > 1) {
+            throw std::runtime_error("SessionHost::load_sessions(): line " + std::to_string(line_number) +
+                                     ": delta churn needs a single querier");
+        }
+        if (options.share_width > 0) {
+            options.bin_count = align_bin_count(options.bin_count, options.bloom_layout, options.bloom_block_bins);
+        }
+        sessions.push_back(options);
+    }
+    return sessions;
+}
+
+size_t SessionHost::footprint(const Options& options) {
+    /* Share size as in ApproximateMpsiParty::zero_share_byte_count() */
+    size_t share_bytes = SHARE_BYTE_COUNT * options.bin_count;
+    if (options.encoding == "fuse") {
+        share_bytes = BinaryFuseFilter(options.set_size, options.fuse_fingerprint_bytes, RANDOM_SEED).byte_size();
+    } else if (options.share_width > 0) {
+        share_bytes = options.share_width * options.bin_count;
+    }
+    /* Each sender holds its zero share and corrupted share; the server its aggregate and up
+       to one queued share per sender. Inputs cost about four words per element in Set. */
+    const size_t shares = 3 * options.party_count * share_bytes;
+    const size_t inputs = options.party_count * options.set_size * 4 * sizeof(size_t);
+    const size_t lanes = std::min(std::max<size_t>(1, options.concurrent_repetitions), options.repetitions);
+    return (shares + inputs) * lanes;
+}
+
+size_t SessionHost::run(const std::vector<Options>& sessions) {
+    std::vector<HostedSession> hosted(sessions.size());
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        hosted[i].id = i;
+        hosted[i].options = sessions[i];
+        hosted[i].footprint = footprint(sessions[i]);
+    }
+
+    /* Started before any session so its workers are shared, not created per session */
+    compute_pool();
+    std::vector<std::thread> runners;
+    for (auto& session : hosted) {
+        if (memory_budget > 0 && session.footprint > memory_budget) {
+            session.status = "rejected";
+            std::cout<<"SessionHost::run(): rejected session "<<session.id<<": needs "<<session.footprint
+                     <<" bytes, budget is "<<memory_budget<<"\n";
+            continue;
+        }
+        /* Arrival order: a large session waiting for memory holds back the ones behind it
+           rather than being overtaken indefinitely */
+        admit(session);
+        runners.emplace_back([this, &session]() {
+            run_session(session);
+            release(session);
+        });
+    }
+    for (auto& runner : runners) {
+        runner.join();
+    }
+
+    print_summary(hosted);
+    return std::count_if(hosted.begin(), hosted.end(), [](const HostedSession& session) {
+        return session.status == "done" && session.successes == session.options.repetitions;
+    });
+}
+
+void SessionHost::admit(HostedSession& session) {
+    const auto queued_time = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(admission_mutex);
+    admission_cv.wait(lock, [&]() {
+        return active < max_active && (memory_budget == 0 || reserved + session.footprint <= memory_budget);
+    });
+    ++active;
+    reserved += session.footprint;
+    session.status = "running";
+    session.wait_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - queued_time).count();
+    std::cout<<"SessionHost::admit(): session "<<session.id<<" admitted after "<<session.wait_ms<<" ms ("
+             <<session.footprint<<" bytes, "<<active<<" running, "<<reserved<<" bytes reserved)\n";
+}
+
+void SessionHost::release(const HostedSession& session) {
+    {
+        std::lock_guard<std::mutex> lock(admission_mutex);
+        --active;
+        reserved -= session.footprint;
+    }
+    admission_cv.notify_all();
+}
+
+void SessionHost::run_session(HostedSession& session) {
+    const Options& options = session.options;
+    Stats stats(session_results_filename(options.results_filename, session.id), options);
+    FullMesh network(options.latency, options.bytes_per_sec, options.party_count, stats);
+    ApproximateMpsi protocol(network, options.bin_count, options.hash_count, options.hash_function,
+                             options.domain_size, options.set_size, options, stats);
+    if (party_scheduler) {
+        protocol.use_party_scheduler(*party_scheduler, session.id);
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    try {
+        network.set_speed_model(SpeedModel::from_options(options));
+        session.successes = protocol.evaluate("Session " + std::to_string(session.id), options.party_count,
+                                              network, options.repetitions);
+        session.status = "done";
+    } catch (const std::exception& e) {
+        session.status = "failed";
+        std::cerr<<"SessionHost::run_session(): session "<<session.id<<" failed: "<<e.what()<<"\n";
+    }
+    session.run_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+/* results.csv -> results_session3.csv */
+std::string SessionHost::session_results_filename(const std::string& results_filename, size_t id) {
+    const size_t dot = results_filename.rfind('.');
+    const std::string suffix = "_session" + std::to_string(id);
+    if (dot == std::string::npos) {
+        return results_filename + suffix;
+    }
+    return results_filename.substr(0, dot) + suffix + results_filename.substr(dot);
+}
+
+void SessionHost::print_summary(const std::vector<HostedSession>& sessions) {
+    std::cout << "Session Summary:\n";
+    for (const auto& session : sessions) {
+        std::cout << "  Session " << session.id << ": " << session.status
+                  << ", parties " << session.options.party_count << ", set size " << session.options.set_size
+                  << ", footprint " << session.footprint << " bytes, waited " << session.wait_ms
+                  << " ms, ran " << session.run_ms << " ms, validated " << session.successes
+                  << " / " << session.options.repetitions << "\n";
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef SESSION_HOST_HPP
+#define SESSION_HOST_HPP
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include "common.hpp"
+#include "TaskRuntime.hpp"
+
+// One tenant of a SessionHost and what became of it
+struct HostedSession {
+    size_t id = 0;
+    Options options;                // Base options with this session's overrides
+    size_t footprint = 0;           // Predicted peak bytes (SessionHost::footprint)
+    std::string status = "queued";  // queued, running, rejected, done or failed
+    size_t successes = 0;           // Repetitions whose outputs validated
+    double wait_ms = 0.0;           // Time spent waiting for admission
+    double run_ms = 0.0;
+};
+
+// Runs many independent protocol instances in one process. Every session has its own
+// options, FullMesh queues and Stats; all of them share the compute pool, one
+// FairScheduler for their send-only parties and one memory budget. Sessions are admitted
+// in arrival order while fewer than 'max_active' run and their predicted footprint fits
+// what the running ones leave of the budget; a session larger than the whole budget is
+// rejected. The filter layout, hash function and share width stay process-wide (Set
+// reads them from g_options), so sessions differ in size and topology, not in encoding.
+class SessionHost {
+public:
+    // 'memory_budget' in bytes (0 = unlimited); 'party_workers' 0 = one thread per party
+    SessionHost(size_t memory_budget, size_t max_active, size_t party_workers);
+
+    // One session per non-empty line of 'path' ('#' starts a comment), written as
+    // whitespace-separated name=value overrides of 'base' using the command-line names
+    static std::vector<Options> load_sessions(const std::string& path, const Options& base);
+
+    // Rough peak memory of one session: shares held by the senders and queued at the server,
+    // plus the input sets, for every concurrently running repetition
+    static size_t footprint(const Options& options);
+
+    // Runs every session to completion; returns the number that validated every repetition
+    size_t run(const std::vector<Options>& sessions);
+
+private:
+    size_t memory_budget;
+    size_t max_active;
+    std::unique_ptr<FairScheduler> party_scheduler;
+
+    std::mutex admission_mutex;
+    std::condition_variable admission_cv;   // Signalled whenever a session releases its memory
+    size_t active = 0;
+    size_t reserved = 0;                    // Footprint of the running sessions
+
+    void admit(HostedSession& session);
+    void release(const HostedSession& session);
+    void run_session(HostedSession& session);
+    static std::string session_results_filename(const std::string& results_filename, size_t id);
+    static void print_summary(const std::vector<HostedSession>& sessions);
+};
+
+#endif // SESSION_HOST_HPP
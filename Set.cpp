@@ -1,9 +1,46 @@
 #include <iostream>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
 #include "Set.hpp"
 #include "hash_funcs.hpp"
 #include "common.hpp"
 #include "secret_sharing_simd.hpp"
 
+static bool is_blocked_layout() {
+    return g_options.bloom_layout == "blocked";
+}
+
+#if USE_BLOOM_FILTER_LIB
+static bool is_library_layout() {
+    return g_options.bloom_layout == "library";
+}
+
+/* Library layout: a batch filter with exactly 'table_size' bits and 'hash_count' hashes, so
+   its bits line up with the share bytes like the in-house filter */
+static batch_bloom_filter make_library_filter(std::size_t table_size, std::size_t hash_count) {
+    bloom_parameters parameters;
+    parameters.projected_element_count = 1;
+    parameters.random_seed = RANDOM_SEED;
+    parameters.optimal_parameters.number_of_hashes = static_cast<unsigned int>(hash_count);
+    parameters.optimal_parameters.table_size = table_size;
+    return batch_bloom_filter(parameters);
+}
+
+/* Positions depend only on the salts and size; reuse one filter per thread for lookups */
+static const batch_bloom_filter& library_probe_filter(std::size_t table_size, std::size_t hash_count) {
+    thread_local batch_bloom_filter filter;
+    if (filter.size() != table_size || filter.hash_count() != hash_count) {
+        filter = make_library_filter(table_size, hash_count);
+    }
+    return filter;
+}
+
+static std::vector<std::uint64_t> library_keys(const std::unordered_set<size_t>& elements) {
+    return std::vector<std::uint64_t>(elements.begin(), elements.end());
+}
+#endif
+
 /* Method Definitions for 'Set' class */
 #if USE_BLOOM_FILTER_LIB
 Set::Set() {
@@ -20,7 +57,7 @@ Set::Set(std::unordered_set<size_t> elems) : elements(std::move(elems)) {
 }
 void Set::bloom_init(unsigned long long element_count, double false_positive_prob, unsigned long long rand_seed) {
        // How many elements roughly do we expect to insert?
-   bl_parameters.projected_element_count = element_count; //1000
+   bl_parameters.projected_element_count = std::max(element_count, 1ULL); //1000
 
    // Maximum tolerable false positive probability? (0,1)
    bl_parameters.false_positive_probability = false_positive_prob; //0.0001; // 1 in 10000
@@ -37,13 +74,14 @@ void Set::bloom_init(unsigned long long element_count, double false_positive_pro
    bl_parameters.compute_optimal_parameters();
 
    //Instantiate Bloom Filter
-    bl_filter = bloom_filter(bl_parameters);
-;
+    bl_filter = batch_bloom_filter(bl_parameters);
 }
 
 void Set::init() {
-    elements.clear();
+    epsilon = FALSE_POSITIVE_PROBABILITY;
     bloom_init(elements.size(), FALSE_POSITIVE_PROBABILITY, RANDOM_SEED);
+    std::vector<std::uint64_t> keys = library_keys(elements);
+    bl_filter.insert_many(keys.data(), keys.size());
 }
 #else
 Set::Set() {
@@ -68,6 +106,7 @@ Set Set::intersection(const std::vector<Set>& sets) {
             if (set.elements.count(elem)) temp.insert(elem);
         }
         result.elements = std::move(temp);
+        result.order.reset();
     }
     return result;
 }
@@ -76,6 +115,39 @@ std::vector<size_t> Set::to_vector() const {
     return {elements.begin(), elements.end()};
 }
 
+Set Set::from_byte_strings(std::shared_ptr<const ByteStringArena> keys, const FingerprintKey& key) {
+    /* One batched hashing pass; only the 64-bit fingerprints enter the bloom/query pipeline */
+    std::vector<uint64_t> fingerprints = keys->fingerprints64(key);
+
+    auto index = std::make_shared<ByteStringIndex>();
+    index->lookup.reserve(fingerprints.size());
+    for (size_t i = 0; i < fingerprints.size(); i++) {
+        index->lookup.emplace_back(fingerprints[i], static_cast<uint32_t>(i));
+    }
+    std::sort(index->lookup.begin(), index->lookup.end());
+    index->keys = std::move(keys);
+
+    Set set(std::unordered_set<size_t>(fingerprints.begin(), fingerprints.end()));
+    set.byte_strings = std::move(index);
+    return set;
+}
+
+bool Set::has_byte_strings() const {
+    return byte_strings != nullptr;
+}
+
+std::optional<std::string_view> Set::byte_string(size_t fingerprint) const {
+    if (!byte_strings) return std::nullopt;
+    const auto& lookup = byte_strings->lookup;
+    auto it = std::lower_bound(lookup.begin(), lookup.end(), std::make_pair(fingerprint, uint32_t{0}));
+    if (it == lookup.end() || it->first != fingerprint) return std::nullopt;
+    return (*byte_strings->keys)[it->second];
+}
+
+void Set::share_byte_strings(const Set& other) {
+    byte_strings = other.byte_strings;
+}
+
 bool Set::operator==(const Set& other) const {
     return elements == other.elements;
 }
@@ -84,6 +156,19 @@ std::unordered_set<size_t> Set::get_elements() const {
     return elements;
 }
 
+const std::vector<size_t>& Set::ordered_elements() const {
+    /* Readers may race to build it; each builds the same vector and one of them is kept */
+    std::shared_ptr<const std::vector<size_t>> cached = std::atomic_load(&order);
+    if (!cached) {
+        cached = std::make_shared<const std::vector<size_t>>(elements.begin(), elements.end());
+        std::shared_ptr<const std::vector<size_t>> expected;
+        if (!std::atomic_compare_exchange_strong(&order, &expected, cached)) {
+            cached = expected;
+        }
+    }
+    return *cached;
+}
+
 /*std::size_t Set::compute_optimal_bit_size(std::size_t n, std::size_t bin_count) const {
     std::size_t base_size = static_cast<std::size_t>(std::ceil(-(n * std::log(epsilon)) / (std::log(2) * std::log(2))));
     std::cout<<"Set::compute_optimal_bit_size: base_size = " <<base_size<<", returns="<<base_size * bin_count<<"\n";
@@ -91,6 +176,11 @@ std::unordered_set<size_t> Set::get_elements() const {
 }*/
 
 std::size_t Set::compute_optimal_bit_size(std::size_t n, std::size_t bin_count) const {
+    if (g_options.share_width > 0) {
+        /* Bin-aligned shares: one filter bit per bin, sized by the caller (or the planner) */
+        return bin_count;
+    }
+
     double bits_per_element = 14.3779296875; // -(std::log(epsilon) / (std::log(2) * std::log(2))); 
     std::size_t bit_array_size = static_cast<std::size_t>(std::ceil(n * bits_per_element));
 
@@ -105,9 +195,124 @@ std::size_t Set::compute_optimal_bit_size(std::size_t n, std::size_t bin_count)
     auto retvalue = std::min(bit_array_size, MAX_BITS);
 
     std::cout<<"Set::compute_optimal_bit_size: Final bit_array_size="<<bit_array_size<<", retvalue="<<retvalue<<"\n";
+
+    if (is_blocked_layout() && n > 0) {
+        /* Blocking costs some accuracy; report what the current size gives and what would match */
+        double actual_bits = static_cast<double>(retvalue) / n;
+        std::cout<<"Set::compute_optimal_bit_size: blocked layout, block bins = "<<g_options.bloom_block_bins
+                 <<", bits/element = "<<actual_bits
+                 <<", predicted FPR = "<<blocked_false_positive_rate(actual_bits, g_options.hash_count, g_options.bloom_block_bins)
+                 <<" (standard layout: "<<standard_false_positive_rate(actual_bits, g_options.hash_count)<<")"
+                 <<", bits/element for FPR "<<FALSE_POSITIVE_PROBABILITY<<" = "
+                 <<blocked_bits_per_element(FALSE_POSITIVE_PROBABILITY, g_options.hash_count, g_options.bloom_block_bins)<<"\n";
+    }
     return retvalue;
 }
 
+std::size_t Set::bloom_filter_size(size_t bin_count) const {
+    std::size_t bit_array_size = compute_optimal_bit_size(elements.size(), bin_count);
+    /* Blocks must tile the filter exactly; the standard layout aligns to whole share chunks */
+    std::size_t alignment = is_blocked_layout() ? g_options.bloom_block_bins : SHARE_BYTE_COUNT;
+    if (bit_array_size % alignment != 0) {
+        bit_array_size += (alignment - (bit_array_size % alignment));
+    }
+    return bit_array_size;
+}
+
+double Set::standard_false_positive_rate(double bits_per_element, size_t hash_count) {
+    return std::pow(1.0 - std::exp(-static_cast<double>(hash_count) / bits_per_element), hash_count);
+}
+
+/* The number of elements landing in a block is ~Poisson(block_bins / bits_per_element);
+   the false positive rate is the average of the per-block rate over that load. */
+double Set::blocked_false_positive_rate(double bits_per_element, size_t hash_count, size_t block_bins) {
+    double lambda = block_bins / bits_per_element;
+    size_t max_load = static_cast<size_t>(lambda + 10 * std::sqrt(lambda) + 20);
+    double log_pmf = -lambda;  // log P(load = 0)
+    double fpr = 0.0;
+    for (size_t j = 0; j <= max_load; j++) {
+        if (j > 0) log_pmf += std::log(lambda) - std::log(static_cast<double>(j));
+        double bit_set = 1.0 - std::pow(1.0 - 1.0 / block_bins, static_cast<double>(hash_count * j));
+        fpr += std::exp(log_pmf) * std::pow(bit_set, hash_count);
+    }
+    return fpr;
+}
+
+double Set::blocked_bits_per_element(double epsilon, size_t hash_count, size_t block_bins) {
+    /* The rate falls monotonically with the size, so bisect on bits per element */
+    double low = 1.0, high = 256.0;
+    if (blocked_false_positive_rate(high, hash_count, block_bins) > epsilon) {
+        return high;
+    }
+    for (int i = 0; i < 50; i++) {
+        double mid = (low + high) / 2;
+        if (blocked_false_positive_rate(mid, hash_count, block_bins) > epsilon) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return high;
+}
+
+std::array<uint64_t, 2> Set::element_digest(const size_t element, const std::string hash_func) {
+    /* Zero-padded to 16 bytes so that every hash in the table yields at least 128 bits */
+    std::array<uint8_t, 2 * sizeof(uint64_t)> element_bytes{};
+    std::memcpy(element_bytes.data(), &element, sizeof(element));
+
+    auto hash_out = generic_hash_func(hash_func, element_bytes.data(), element_bytes.size());
+    std::array<uint64_t, 2> digest{};
+    std::memcpy(digest.data(), hash_out.data(), std::min(sizeof(digest), hash_out.size()));
+    return digest;
+}
+
+std::vector<std::array<uint64_t, 2>> Set::element_digests(const std::string hash_func) const {
+    std::vector<std::array<uint64_t, 2>> digests;
+    digests.reserve(elements.size());
+    for (const auto& element : ordered_elements()) {
+        digests.push_back(element_digest(element, hash_func));
+    }
+    return digests;
+}
+
+void Set::blocked_bloom_indices(const std::array<uint64_t, 2>& digest, size_t range,
+    size_t hash_count, size_t block_bins, std::vector<size_t>& indices) {
+    indices.clear();
+    size_t block_count = std::max<size_t>(1, range / block_bins);
+    size_t block_base = static_cast<size_t>((static_cast<unsigned __int128>(digest[0]) * block_count) >> 64) * block_bins;
+
+    /* Every probe takes its own slice of log2(block_bins) bits of the second word, so probes
+       are independent (double hashing modulo a small block repeats after a few thousand
+       patterns); once the word runs out it is remixed (splitmix64) for further slices.
+       A slice that repeats an earlier probe is skipped: the server XORs the probed bins, so
+       a repeated bin would cancel out instead of being tested. */
+    size_t slice_bits = 1;
+    while ((size_t{1} << slice_bits) < block_bins) slice_bits++;
+    const uint64_t slice_mask = (uint64_t{1} << slice_bits) - 1;
+
+    const size_t probe_count = std::min({hash_count, block_bins, range});
+    uint64_t word = digest[1];
+    size_t bits_left = 64;
+    for (uint64_t round = 1; indices.size() < probe_count; ) {
+        if (bits_left < slice_bits) {
+            word = digest[1] + round++ * 0x9E3779B97F4A7C15ULL;
+            word = (word ^ (word >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            word = (word ^ (word >> 27)) * 0x94D049BB133111EBULL;
+            word ^= word >> 31;
+            bits_left = 64;
+        }
+        uint64_t slice = word & slice_mask;
+        word >>= slice_bits;
+        bits_left -= slice_bits;
+
+        size_t index = block_base + static_cast<size_t>((slice * block_bins) >> slice_bits);
+        index = index < range ? index : index % range;
+        if (std::find(indices.begin(), indices.end(), index) == indices.end()) {
+            indices.push_back(index);
+        }
+    }
+}
+
 std::size_t Set::compute_optimal_hash_count(std::size_t n, std::size_t m) const {
         return static_cast<std::size_t>(std::ceil((m / n) * std::log(2)));
 }
@@ -147,11 +352,23 @@ std::vector<size_t> Set::bloom_filter_indices(const size_t element,
     size_t bin_count, size_t hash_count, const std::string hash_func) const {
     std::vector<size_t> indices;
 
-    std::vector<uint8_t> element_bytes(sizeof(element));
+    if (is_blocked_layout()) {
+        blocked_bloom_indices(element_digest(element, hash_func), bin_count, hash_count, g_options.bloom_block_bins, indices);
+        return indices;
+    }
+#if USE_BLOOM_FILTER_LIB
+    if (is_library_layout()) {
+        library_probe_filter(bin_count, hash_count).positions(element, indices);
+        return indices;
+    }
+#endif
+
+    /* Hash i covers the element and i zero bytes; the padding keeps the read in bounds */
+    std::vector<uint8_t> element_bytes(sizeof(element) + hash_count, 0);
     std::memcpy(element_bytes.data(), &element, sizeof(element));  // Convert element to bytes
 
     for (size_t i = 0; i < hash_count; i++) {
-        auto hash_out = generic_hash_func(hash_func, element_bytes.data(), element_bytes.size() + i);
+        auto hash_out = generic_hash_func(hash_func, element_bytes.data(), sizeof(element) + i);
         size_t hash = extract_hash_value(hash_out) % bin_count;
         indices.push_back(hash);
     }
@@ -161,6 +378,19 @@ std::vector<size_t> Set::bloom_filter_indices(const size_t element,
 
 void Set::insert(size_t element) {
     elements.insert(element);
+    order.reset();
+#if USE_BLOOM_FILTER_LIB
+    bl_filter.insert(static_cast<std::uint64_t>(element));
+#endif
+}
+
+void Set::erase(size_t element) {
+    elements.erase(element);
+    order.reset();
+}
+
+bool Set::contains(size_t element) const {
+    return elements.count(element) != 0;
 }
 
 // Convert the set into a Bloom filter representation
@@ -180,17 +410,43 @@ std::vector<bool> Set::to_bloom_filter2(size_t bin_count, size_t hash_count, std
 
 std::vector<std::vector<size_t>> Set::bloom_filter_indices(size_t bin_count, size_t hash_count, const std::string hash_func) const {
     std::vector<std::vector<size_t>> indices;
-    std::size_t bit_array_size = compute_optimal_bit_size(elements.size(), bin_count);
 
-    for (const auto& element : elements) {
+    if (is_blocked_layout()) {
+        /* Same positions as to_bloom_filter(): the server probes share bytes directly */
+        std::size_t filter_size = bloom_filter_size(bin_count);
+        indices.reserve(elements.size());
+        for (const auto& element : ordered_elements()) {
+            std::vector<size_t> indic;
+            blocked_bloom_indices(element_digest(element, hash_func), filter_size, hash_count, g_options.bloom_block_bins, indic);
+            indices.push_back(std::move(indic));
+        }
+        return indices;
+    }
+#if USE_BLOOM_FILTER_LIB
+    if (is_library_layout()) {
+        const batch_bloom_filter& filter = library_probe_filter(bloom_filter_size(bin_count), hash_count);
+        indices.resize(elements.size());
+        size_t i = 0;
+        for (const auto& element : ordered_elements()) {
+            filter.positions(element, indices[i++]);
+        }
+        return indices;
+    }
+#endif
+
+    /* Same positions as to_bloom_filter(): the legacy share holds one byte per filter bit,
+       so indices span the whole filter rather than bin_count */
+    std::size_t bit_array_size = bloom_filter_size(bin_count);
+
+    for (const auto& element : ordered_elements()) {
         std::vector<size_t> indic;
-        std::vector<uint8_t> element_bytes(sizeof(element));
+        std::vector<uint8_t> element_bytes(sizeof(element) + hash_count, 0);
         std::memcpy(element_bytes.data(), &element, sizeof(element));  // Convert element to bytes
 
         for (std::size_t i = 0; i < hash_count; ++i) {
-            std::vector<uint8_t> hash_result = generic_hash_func(hash_func, element_bytes.data(), element_bytes.size() + i);
+            std::vector<uint8_t> hash_result = generic_hash_func(hash_func, element_bytes.data(), sizeof(element) + i);
             std::size_t hash_value = extract_hash_value(hash_result) % bit_array_size;
-            indic.push_back(hash_value % bin_count); // Map indices to bin count
+            indic.push_back(hash_value);
         }
         indices.push_back(indic);
     }
@@ -198,18 +454,36 @@ std::vector<std::vector<size_t>> Set::bloom_filter_indices(size_t bin_count, siz
 }
 
 std::vector<bool> Set::to_bloom_filter(size_t bin_count, size_t hash_count, std::string hash_func) const {
-    std::size_t bit_array_size = compute_optimal_bit_size(elements.size(), bin_count);
-    if (bit_array_size% SHARE_BYTE_COUNT != 0) {
-        bit_array_size += (SHARE_BYTE_COUNT - (bit_array_size % SHARE_BYTE_COUNT)); // Align to SHARE_BYTE_COUNT
-    }
+    std::size_t bit_array_size = bloom_filter_size(bin_count); // Aligned to SHARE_BYTE_COUNT (or the block size)
  
     std::vector<bool> bit_array(bit_array_size, false);  // Bit array initialized with false
 
+    if (is_blocked_layout()) {
+        /* One digest per element and every bit in a single block */
+        std::vector<size_t> indices;
+        for (const auto& element : elements) {
+            blocked_bloom_indices(element_digest(element, hash_func), bit_array_size, hash_count, g_options.bloom_block_bins, indices);
+            for (size_t idx : indices) {
+                bit_array[idx] = true;
+            }
+        }
+        return bit_array;
+    }
+#if USE_BLOOM_FILTER_LIB
+    if (is_library_layout()) {
+        /* Hash and set the whole set in batches on the word table */
+        batch_bloom_filter filter = make_library_filter(bit_array_size, hash_count);
+        std::vector<std::uint64_t> keys = library_keys(elements);
+        filter.insert_many(keys.data(), keys.size());
+        return filter.to_bits();
+    }
+#endif
+
     for (const auto& element : elements) {
-        std::vector<uint8_t> element_bytes(sizeof(element));
+        std::vector<uint8_t> element_bytes(sizeof(element) + hash_count, 0);
         std::memcpy(element_bytes.data(), &element, sizeof(element));  // Convert element to bytes
         for (std::size_t i = 0; i < hash_count; ++i) {
-            auto hash_out = generic_hash_func(hash_func, element_bytes.data(), element_bytes.size() + i);
+            auto hash_out = generic_hash_func(hash_func, element_bytes.data(), sizeof(element) + i);
             size_t hash_value = extract_hash_value(hash_out) % bit_array_size;
             bit_array[hash_value] = true;
         }
@@ -3,23 +3,45 @@
 
 #include <unordered_set>
 #include <vector>
+#include <array>
+#include <cstdint>
 #include <optional>
+#include <memory>
+#include <string_view>
 #include <boost/container_hash/hash.hpp>
 //#include "secret_sharing_simd.hpp"
+#include "ByteStringArena.hpp"
 #if USE_BLOOM_FILTER_LIB
 #include "bloom_filter.hpp"
 #endif
 
+// Original byte-string keys behind a fingerprinted set, shared between copies
+struct ByteStringIndex {
+    std::shared_ptr<const ByteStringArena> keys;
+    std::vector<std::pair<size_t, uint32_t>> lookup; // Sorted (fingerprint, arena index)
+};
+
 class Set {
 public:
     Set();
     Set(std::unordered_set<size_t> elems);
     explicit Set(std::initializer_list<size_t> init);
     void insert(size_t element);
+
+    /* Byte-string elements: the set holds 64-bit keyed fingerprints of the arena's keys */
+    static Set from_byte_strings(std::shared_ptr<const ByteStringArena> keys, const FingerprintKey& key);
+    bool has_byte_strings() const;
+    std::optional<std::string_view> byte_string(size_t fingerprint) const;
+    void share_byte_strings(const Set& other);
+    void erase(size_t element);
+    bool contains(size_t element) const;
     static Set intersection(const std::vector<Set>& sets);
     std::vector<size_t> to_vector() const;
     bool operator==(const Set& other) const;
     std::unordered_set<size_t> get_elements() const;
+    /* Elements in one stable, contiguous order, built once and kept until the set changes.
+       Query patterns, digests and extract_intersection() all follow this order. */
+    const std::vector<size_t>& ordered_elements() const;
     std::vector<size_t> bloom_filter_indices_std_hash(const size_t element, 
         size_t bin_count, size_t hash_count);
     std::vector<size_t> bloom_filter_indices_boost_hash(const size_t element, 
@@ -32,14 +54,31 @@ public:
         size_t bin_count, size_t hash_count, const std::string hash_function) const;
     
     std::vector<std::vector<size_t>>  bloom_filter_indices(size_t bin_count, size_t hash_count, const std::string hash_func) const;    
-    
+
+    /* Number of bits in the filter built by to_bloom_filter() (aligned for the active layout) */
+    std::size_t bloom_filter_size(size_t bin_count) const;
+
+    /* Blocked layout: one 128-bit digest per element; the first word picks a block of
+       'block_bins' bins and the second word places all 'hash_count' bits inside it. */
+    static std::array<uint64_t, 2> element_digest(const size_t element, const std::string hash_func);
+    /* Digests of all elements, in the order bloom_filter_indices() visits them */
+    std::vector<std::array<uint64_t, 2>> element_digests(const std::string hash_func) const;
+    static void blocked_bloom_indices(const std::array<uint64_t, 2>& digest, size_t range,
+        size_t hash_count, size_t block_bins, std::vector<size_t>& indices);
+
+    /* Parameter guidance for the blocked layout */
+    static double standard_false_positive_rate(double bits_per_element, size_t hash_count);
+    static double blocked_false_positive_rate(double bits_per_element, size_t hash_count, size_t block_bins);
+    static double blocked_bits_per_element(double epsilon, size_t hash_count, size_t block_bins);
 
 private:
     double epsilon; /* False positive probability */
     std::unordered_set<size_t> elements;
+    std::shared_ptr<const ByteStringIndex> byte_strings;
+    mutable std::shared_ptr<const std::vector<size_t>> order; /* Cache for ordered_elements() */
 #if USE_BLOOM_FILTER_LIB
     bloom_parameters bl_parameters;
-    bloom_filter bl_filter;
+    batch_bloom_filter bl_filter;
     void bloom_init(unsigned long long element_count, double false_positive_prob, unsigned long long rand_seed);
     void init();
 #endif
@@ -52,4 +91,5 @@ private:
 using Input = std::optional<Set>;
 const unsigned long long RANDOM_SEED = 0xA5A5A5A5;
 const double FALSE_POSITIVE_PROBABILITY = 0.0001;                          
+const size_t DEFAULT_BLOOM_BLOCK_BINS = 64; /* 64 one-byte share bins = one cache line */
 #endif // SET_HPP
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include <stdexcept>
+#include "ShardLayout.hpp"
+
+/* Method Definitions for 'ShardLayout' class */
+ShardLayout::ShardLayout(size_t shard_count, size_t unit_count, size_t unit_bytes)
+    : shards(shard_count), units(unit_count), unit_bytes(unit_bytes) {
+    if (shard_count == 0 || unit_bytes == 0) {
+        throw std::invalid_argument("ShardLayout: shard count and unit size must be non-zero");
+    }
+}
+
+size_t ShardLayout::shard_count() const {
+    return shards;
+}
+
+size_t ShardLayout::first_unit(size_t shard) const {
+    return shard * units / shards;
+}
+
+size_t ShardLayout::unit_count(size_t shard) const {
+    return first_unit(shard + 1) - first_unit(shard);
+}
+
+size_t ShardLayout::owner(size_t unit) const {
+    size_t shard = unit * shards / (units == 0 ? 1 : units);
+    while (shard + 1 < shards && first_unit(shard + 1) <= unit) ++shard;
+    while (shard > 0 && first_unit(shard) > unit) --shard;
+    return shard;
+}
+
+size_t ShardLayout::byte_begin(size_t shard) const {
+    return first_unit(shard) * unit_bytes;
+}
+
+size_t ShardLayout::byte_end(size_t shard) const {
+    return first_unit(shard + 1) * unit_bytes;
+}
+
+size_t ShardLayout::endpoint(size_t shard, size_t party_count) {
+    return shard == 0 ? 0 : party_count + shard;
+}
@@ -0,0 +1,31 @@
+#ifndef SHARD_LAYOUT_HPP
+#define SHARD_LAYOUT_HPP
+
+#include <cstddef>
+
+// Partition of the aggregated share across server shards by bin range. The share is
+// 'unit_count' probe units (bins) of 'unit_bytes' each; shard s owns units
+// [first_unit(s), first_unit(s + 1)) and holds only those bytes.
+class ShardLayout {
+public:
+    ShardLayout(size_t shard_count, size_t unit_count, size_t unit_bytes);
+
+    size_t shard_count() const;
+    size_t first_unit(size_t shard) const;
+    size_t unit_count(size_t shard) const;
+    size_t owner(size_t unit) const;
+
+    size_t byte_begin(size_t shard) const;
+    size_t byte_end(size_t shard) const;
+
+    // FullMesh endpoint of a shard: shard 0 is the server (party 0), the others sit after
+    // the protocol parties and the daemon's query endpoint
+    static size_t endpoint(size_t shard, size_t party_count);
+
+private:
+    size_t shards;
+    size_t units;
+    size_t unit_bytes;
+};
+
+#endif // SHARD_LAYOUT_HPP
@@ -0,0 +1,187 @@
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include <sys/stat.h>
+#include "ShareEpochServer.hpp"
+#include "blake3.h"
+
+namespace {
+constexpr uint64_t SNAPSHOT_MAGIC = 0x32484345525053ULL; // "SPRECH2"
+constexpr uint64_t SNAPSHOT_VERSION = 2;
+constexpr size_t SNAPSHOT_HEADER_BYTES = 4096;
+constexpr size_t SNAPSHOT_ENCODING_BYTES = 32;
+
+struct SnapshotHeader {
+    uint64_t magic;
+    uint64_t version;
+    uint64_t epoch;
+    uint64_t byte_count;
+    uint64_t payload_offset;
+    uint8_t checksum[BLAKE3_OUT_LEN];
+    char encoding[SNAPSHOT_ENCODING_BYTES];  // NUL-padded
+    uint64_t bin_count;
+    uint64_t probe_width;
+    uint64_t hash_count;
+    uint64_t set_size;
+    uint64_t party_count;
+};
+static_assert(sizeof(SnapshotHeader) <= SNAPSHOT_HEADER_BYTES, "Snapshot header must fit its page");
+
+void share_checksum(const uint8_t* data, size_t size, uint8_t out[BLAKE3_OUT_LEN]) {
+    blake3_hasher hasher;
+    blake3_hasher_init(&hasher);
+    blake3_hasher_update(&hasher, data, size);
+    blake3_hasher_finalize(&hasher, out, BLAKE3_OUT_LEN);
+}
+}
+
+/* Method Definitions for 'ShareShape' struct */
+bool ShareShape::operator==(const ShareShape& other) const {
+    return encoding == other.encoding && bin_count == other.bin_count && probe_width == other.probe_width &&
+           hash_count == other.hash_count && set_size == other.set_size && party_count == other.party_count;
+}
+
+std::string ShareShape::describe() const {
+    return encoding + ", " + std::to_string(bin_count) + " bins of " + std::to_string(probe_width) + " bytes, " +
+           std::to_string(hash_count) + " hashes, set size " + std::to_string(set_size) + ", " +
+           std::to_string(party_count) + " parties";
+}
+
+/* Method Definitions for 'EpochShare' class */
+EpochShare::EpochShare(size_t epoch, SimdBytes share)
+    : epoch_id(epoch), owned(std::move(share)), byte_count(owned.size()) {}
+
+EpochShare::EpochShare(size_t epoch, MappedFile file, size_t offset, size_t byte_count)
+    : epoch_id(epoch), file(std::move(file)), offset(offset), byte_count(byte_count) {}
+
+size_t EpochShare::epoch() const {
+    return epoch_id;
+}
+
+const uint8_t* EpochShare::data() const {
+    return file.is_open() ? file.data() + offset : owned.bytes.data();
+}
+
+size_t EpochShare::size() const {
+    return byte_count;
+}
+
+bool EpochShare::is_mapped() const {
+    return file.is_open();
+}
+
+/* Method Definitions for 'ShareEpochServer' class */
+ShareEpochServer::ShareEpochServer(std::string dir, ShareShape shape) : dir(std::move(dir)), shape(std::move(shape)) {
+    if (this->shape.encoding.size() >= SNAPSHOT_ENCODING_BYTES) {
+        throw std::invalid_argument("ShareEpochServer: encoding name '" + this->shape.encoding + "' is too long");
+    }
+}
+
+std::string ShareEpochServer::path() const {
+    return dir + "/aggregate_share.snap";
+}
+
+std::shared_ptr<const EpochShare> ShareEpochServer::current() const {
+    return std::atomic_load(&live);
+}
+
+std::shared_ptr<const EpochShare> ShareEpochServer::wait_current() const {
+    std::unique_lock<std::mutex> lock(publish_mutex);
+    published.wait(lock, [this]() { return std::atomic_load(&live) != nullptr; });
+    return std::atomic_load(&live);
+}
+
+void ShareEpochServer::make_live(std::shared_ptr<const EpochShare> next) {
+    {
+        /* Readers never take the lock; it only orders the swap with wait_current() */
+        std::lock_guard<std::mutex> lock(publish_mutex);
+        std::atomic_store(&live, std::move(next));
+    }
+    published.notify_all();
+}
+
+void ShareEpochServer::publish(size_t epoch, SimdBytes&& share) {
+    auto next = std::make_shared<const EpochShare>(epoch, std::move(share));
+    persist(*next);
+    make_live(std::move(next));
+    std::cout<<"ShareEpochServer::publish(): epoch "<<epoch<<" is live\n";
+}
+
+void ShareEpochServer::persist(const EpochShare& epoch_share) const {
+    const std::string final_path = path();
+    const std::string tmp_path = final_path + ".tmp";
+    {
+        SnapshotHeader header{};
+        header.magic = SNAPSHOT_MAGIC;
+        header.version = SNAPSHOT_VERSION;
+        header.epoch = epoch_share.epoch();
+        header.byte_count = epoch_share.size();
+        header.payload_offset = SNAPSHOT_HEADER_BYTES;
+        share_checksum(epoch_share.data(), epoch_share.size(), header.checksum);
+        std::memcpy(header.encoding, shape.encoding.data(), shape.encoding.size());
+        header.bin_count = shape.bin_count;
+        header.probe_width = shape.probe_width;
+        header.hash_count = shape.hash_count;
+        header.set_size = shape.set_size;
+        header.party_count = shape.party_count;
+
+        MappedFile file = MappedFile::create(tmp_path, SNAPSHOT_HEADER_BYTES + epoch_share.size());
+        std::memset(file.data(), 0, SNAPSHOT_HEADER_BYTES);
+        std::memcpy(file.data(), &header, sizeof(header));
+        std::memcpy(file.data() + SNAPSHOT_HEADER_BYTES, epoch_share.data(), epoch_share.size());
+        file.sync();
+    }
+    if (std::rename(tmp_path.c_str(), final_path.c_str()) != 0) {
+        throw std::runtime_error("ShareEpochServer::persist: cannot rename '" + tmp_path + "'");
+    }
+}
+
+bool ShareEpochServer::restore(bool verify, bool populate) {
+    auto start_time = std::chrono::steady_clock::now();
+    struct stat st;
+    if (::stat(path().c_str(), &st) != 0) {
+        return false;
+    }
+    /* Queries probe the share at random, so skip read-ahead unless populating */
+    MappedFile file = MappedFile::open_read(path(), !populate, populate);
+    SnapshotHeader header;
+    if (file.size() < SNAPSHOT_HEADER_BYTES) {
+        std::cout<<"ShareEpochServer::restore(): ignoring '"<<path()<<"' (truncated)\n";
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION ||
+        header.payload_offset != SNAPSHOT_HEADER_BYTES || file.size() != header.payload_offset + header.byte_count) {
+        std::cout<<"ShareEpochServer::restore(): ignoring '"<<path()<<"' (bad header)\n";
+        return false;
+    }
+    ShareShape stored;
+    stored.encoding.assign(header.encoding, strnlen(header.encoding, SNAPSHOT_ENCODING_BYTES));
+    stored.bin_count = header.bin_count;
+    stored.probe_width = header.probe_width;
+    stored.hash_count = header.hash_count;
+    stored.set_size = header.set_size;
+    stored.party_count = header.party_count;
+    if (!(stored == shape)) {
+        std::cout<<"ShareEpochServer::restore(): ignoring '"<<path()<<"' (built for "<<stored.describe()
+                 <<", not "<<shape.describe()<<")\n";
+        return false;
+    }
+    if (verify) {
+        uint8_t checksum[BLAKE3_OUT_LEN];
+        share_checksum(file.data() + header.payload_offset, header.byte_count, checksum);
+        if (std::memcmp(checksum, header.checksum, BLAKE3_OUT_LEN) != 0) {
+            std::cout<<"ShareEpochServer::restore(): ignoring '"<<path()<<"' (checksum mismatch)\n";
+            return false;
+        }
+    }
+
+    make_live(std::make_shared<const EpochShare>(header.epoch, std::move(file), header.payload_offset, header.byte_count));
+    auto end_time = std::chrono::steady_clock::now();
+    std::cout<<"ShareEpochServer::restore(): serving epoch "<<header.epoch<<" ("<<header.byte_count<<" bytes) from '"<<path()
+             <<"' after "<<std::chrono::duration<double, std::milli>(end_time - start_time).count()<<" ms"
+             <<(verify ? "" : " (unverified)")<<"\n";
+    return true;
+}
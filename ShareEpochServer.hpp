@@ -0,0 +1,82 @@
+#ifndef SHARE_EPOCH_SERVER_HPP
+#define SHARE_EPOCH_SERVER_HPP
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include "MappedFile.hpp"
+#include "secret_sharing_simd.hpp"
+
+// One finished aggregate, immutable once published: either the share the daemon just
+// built or a snapshot file mapped in place. Either way it is read through data()/size().
+class EpochShare {
+public:
+    EpochShare(size_t epoch, SimdBytes share);
+    EpochShare(size_t epoch, MappedFile file, size_t offset, size_t byte_count);
+
+    size_t epoch() const;
+    const uint8_t* data() const;
+    size_t size() const;
+    bool is_mapped() const;
+
+private:
+    size_t epoch_id;
+    SimdBytes owned;
+    MappedFile file;
+    size_t offset = 0;
+    size_t byte_count = 0;
+};
+
+// What an aggregate was built for. A snapshot of another shape (bin count, probe width,
+// encoding, ...) would be probed at the wrong positions, so restore() does not serve it.
+struct ShareShape {
+    std::string encoding;       // "fuse" or "bloom/<layout>"
+    uint64_t bin_count = 0;
+    uint64_t probe_width = 0;
+    uint64_t hash_count = 0;
+    uint64_t set_size = 0;
+    uint64_t party_count = 0;
+
+    bool operator==(const ShareShape& other) const;
+    std::string describe() const;
+};
+
+// Server state of the long-running daemon. Queries read the live epoch through current(),
+// which hands out a reference-counted snapshot; publish() swaps in the next epoch's
+// aggregate atomically (RCU-style), and the old one is freed when its last reader drops
+// it. Each epoch is persisted before it goes live, so a restart serves it again without
+// clients resending.
+//
+// Snapshot file: one 4 KB header page, then the share. The share starts page-aligned so
+// the mapping can be probed in place with aligned loads; the header carries a BLAKE3
+// checksum of the share and the shape it was built for.
+class ShareEpochServer {
+public:
+    ShareEpochServer(std::string dir, ShareShape shape);
+
+    std::shared_ptr<const EpochShare> current() const;   // Null before the first epoch
+    std::shared_ptr<const EpochShare> wait_current() const;
+
+    void publish(size_t epoch, SimdBytes&& share);
+
+    // Map the last snapshot and serve it without copying; false if there is none, it was
+    // built for another shape or it fails validation. 'verify' checksums the share (reads all of it); 'populate' faults
+    // it in up front instead of on first probe.
+    bool restore(bool verify = true, bool populate = false);
+
+    std::string path() const;
+
+private:
+    std::string dir;
+    ShareShape shape;
+    std::shared_ptr<const EpochShare> live;  // Only touched through std::atomic_load/store
+    mutable std::mutex publish_mutex;
+    mutable std::condition_variable published;
+
+    void persist(const EpochShare& epoch_share) const;
+    void make_live(std::shared_ptr<const EpochShare> next);
+};
+
+#endif // SHARE_EPOCH_SERVER_HPP
@@ -0,0 +1,163 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "SpeedModel.hpp"
+
+/* Method Definitions for 'SpeedModel' class */
+SpeedModel::SpeedModel(size_t party_count, const PartyProfile& base) : base(base), parties(party_count, base) {}
+
+void SpeedModel::sample(double slowdown_sigma, double latency_sigma, double bandwidth_sigma, uint64_t seed) {
+    std::mt19937_64 rng(seed != 0 ? seed : std::random_device{}());
+    std::normal_distribution<double> slowdown(0.0, slowdown_sigma > 0.0 ? slowdown_sigma : 1.0);
+    std::normal_distribution<double> latency(0.0, latency_sigma > 0.0 ? latency_sigma : 1.0);
+    std::normal_distribution<double> bandwidth(0.0, bandwidth_sigma > 0.0 ? bandwidth_sigma : 1.0);
+
+    /* Each draw is taken whether or not it is used, so one seed gives the same fleet for any sigma mix */
+    for (PartyProfile& profile : parties) {
+        double slowdown_draw = slowdown(rng);
+        double latency_draw = latency(rng);
+        double bandwidth_draw = bandwidth(rng);
+        if (slowdown_sigma > 0.0) profile.slowdown = base.slowdown * std::exp(std::abs(slowdown_draw));
+        if (latency_sigma > 0.0) profile.latency = base.latency * std::exp(latency_draw);
+        /* An unlimited link stays unlimited: there is no median to spread around */
+        if (bandwidth_sigma > 0.0 && base.bytes_per_sec > 0.0) {
+            profile.bytes_per_sec = base.bytes_per_sec * std::exp(bandwidth_draw);
+        }
+    }
+}
+
+void SpeedModel::load(const std::string& path, size_t queriers) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("SpeedModel::load(): cannot open " + path);
+    }
+
+    std::string line;
+    for (size_t line_number = 1; std::getline(file, line); ++line_number) {
+        const std::string where = "SpeedModel::load(): line " + std::to_string(line_number) + ": ";
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string kind;
+        if (!(fields >> kind)) continue;
+
+        try {
+            if (kind == "party") {
+                std::string target;
+                fields >> target;
+                size_t first = 0;
+                size_t last = 0;
+                if (target == "all") {
+                    last = parties.size() - 1;
+                } else if (target == "clients") {
+                    first = queriers + 1;
+                    last = parties.size() - 1;
+                } else {
+                    const size_t dash = target.find('-');
+                    first = std::stoull(target.substr(0, dash));
+                    last = dash == std::string::npos ? first : std::stoull(target.substr(dash + 1));
+                }
+                if (first > last || last >= parties.size()) {
+                    throw std::runtime_error(where + "party '" + target + "' is out of range");
+                }
+
+                std::string field;
+                while (fields >> field) {
+                    const size_t equals = field.find('=');
+                    const std::string key = field.substr(0, equals);
+                    const double value = std::stod(field.substr(equals == std::string::npos ? field.size() : equals + 1));
+                    for (size_t id = first; id <= last; ++id) {
+                        if (key == "slowdown" && value >= 1.0) parties[id].slowdown = value;
+                        else if (key == "latency" && value >= 0.0) parties[id].latency = value;
+                        else if (key == "bandwidth" && value >= 0.0) parties[id].bytes_per_sec = value;
+                        else throw std::runtime_error(where + "unsupported setting '" + field + "'");
+                    }
+                }
+            } else if (kind == "link") {
+                size_t a = 0;
+                size_t b = 0;
+                if (!(fields >> a >> b) || a == b) {
+                    throw std::runtime_error(where + "a link needs two different party ids");
+                }
+                LinkOverride& link = links[{std::min(a, b), std::max(a, b)}];
+                std::string field;
+                while (fields >> field) {
+                    const size_t equals = field.find('=');
+                    const std::string key = field.substr(0, equals);
+                    const double value = std::stod(field.substr(equals == std::string::npos ? field.size() : equals + 1));
+                    if (key == "latency" && value >= 0.0) link.latency = value;
+                    else if (key == "bandwidth" && value >= 0.0) link.bytes_per_sec = value;
+                    else throw std::runtime_error(where + "unsupported setting '" + field + "'");
+                }
+            } else {
+                throw std::runtime_error(where + "expected 'party' or 'link', got '" + kind + "'");
+            }
+        } catch (const std::logic_error&) {
+            throw std::runtime_error(where + "bad value");
+        }
+    }
+}
+
+std::shared_ptr<const SpeedModel> SpeedModel::from_options(const Options& options) {
+    if (options.speed_profile.empty() && options.slowdown_sigma <= 0.0 &&
+        options.latency_sigma <= 0.0 && options.bandwidth_sigma <= 0.0) {
+        return nullptr;
+    }
+
+    PartyProfile base;
+    base.latency = options.latency;
+    base.bytes_per_sec = options.bytes_per_sec;
+    auto model = std::make_shared<SpeedModel>(options.party_count + 1, base);
+    model->sample(options.slowdown_sigma, options.latency_sigma, options.bandwidth_sigma, options.speed_seed);
+    if (!options.speed_profile.empty()) {
+        model->load(options.speed_profile, options.queriers);
+    }
+    return model;
+}
+
+const PartyProfile& SpeedModel::party(size_t id) const {
+    return id < parties.size() ? parties[id] : base;
+}
+
+double SpeedModel::link_latency(size_t from, size_t to) const {
+    auto link = links.find({std::min(from, to), std::max(from, to)});
+    if (link != links.end() && link->second.latency >= 0.0) {
+        return link->second.latency;
+    }
+    return std::max(party(from).latency, party(to).latency);
+}
+
+double SpeedModel::link_bytes_per_sec(size_t from, size_t to) const {
+    auto link = links.find({std::min(from, to), std::max(from, to)});
+    if (link != links.end() && link->second.bytes_per_sec >= 0.0) {
+        return link->second.bytes_per_sec;
+    }
+    /* The slower end limits the transfer; 0 means that end is unlimited */
+    double sender = party(from).bytes_per_sec;
+    double receiver = party(to).bytes_per_sec;
+    if (sender <= 0.0) return receiver;
+    if (receiver <= 0.0) return sender;
+    return std::min(sender, receiver);
+}
+
+void SpeedModel::print_summary() const {
+    auto spread = [&](double PartyProfile::*field) {
+        std::vector<double> values;
+        for (const PartyProfile& profile : parties) {
+            values.push_back(profile.*field);
+        }
+        std::sort(values.begin(), values.end());
+        auto at = [&](double q) { return values[static_cast<size_t>(q * (values.size() - 1))]; };
+        std::ostringstream out;
+        out << "min=" << values.front() << ", p50=" << at(0.5) << ", p90=" << at(0.9) << ", max=" << values.back();
+        return out.str();
+    };
+
+    std::cout << "SpeedModel::print_summary(): " << parties.size() << " parties, " << links.size() << " link overrides\n";
+    std::cout << "  slowdown:        " << spread(&PartyProfile::slowdown) << "\n";
+    std::cout << "  latency (ms):    " << spread(&PartyProfile::latency) << "\n";
+    std::cout << "  bytes per sec:   " << spread(&PartyProfile::bytes_per_sec) << "\n";
+}
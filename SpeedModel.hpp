@@ -0,0 +1,59 @@
+#ifndef SPEED_MODEL_HPP
+#define SPEED_MODEL_HPP
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include "common.hpp"
+
+// Compute speed and access link of one party
+struct PartyProfile {
+    double slowdown = 1.0;      // Local computation takes this many times as long as on the host
+    double latency = 0.0;       // Per-message latency in ms (as FullMesh applies it)
+    double bytes_per_sec = 0.0; // Link bandwidth (0 = unlimited)
+};
+
+// Heterogeneous parties for tail-latency simulation. A message from a to b pays the larger
+// of the two ends' latencies and the smaller of their bandwidths, unless the pair has its
+// own link entry. Profiles start from the command-line latency and bandwidth, can be
+// sampled log-normally around them, and are then overridden by a profile file.
+class SpeedModel {
+public:
+    SpeedModel(size_t party_count, const PartyProfile& base);
+
+    // Latency and bandwidth are log-normal around the base values (sigma of the log);
+    // slowdowns are exp(|N(0, slowdown_sigma)|), so no party runs faster than the host
+    void sample(double slowdown_sigma, double latency_sigma, double bandwidth_sigma, uint64_t seed);
+
+    // One entry per line ('#' starts a comment):
+    //   party <id>|<first>-<last>|clients|all [slowdown=X] [latency=MS] [bandwidth=BYTES_PER_SEC]
+    //   link <a> <b> [latency=MS] [bandwidth=BYTES_PER_SEC]
+    // 'clients' are the parties after the queriers; later lines override earlier ones
+    void load(const std::string& path, size_t queriers);
+
+    // Null when every party and link is as fast as the plain --latency/--bytes-per-sec mesh
+    static std::shared_ptr<const SpeedModel> from_options(const Options& options);
+
+    // Endpoints past the parties (server shards, the daemon's query endpoint) get the base profile
+    const PartyProfile& party(size_t id) const;
+    double link_latency(size_t from, size_t to) const;
+    double link_bytes_per_sec(size_t from, size_t to) const;
+
+    void print_summary() const;
+
+private:
+    struct LinkOverride {
+        double latency = -1.0;        // Negative: not overridden
+        double bytes_per_sec = -1.0;
+    };
+
+    PartyProfile base;
+    std::vector<PartyProfile> parties;
+    std::map<std::pair<size_t, size_t>, LinkOverride> links;  // Keyed (min id, max id)
+};
+
+#endif // SPEED_MODEL_HPP
@@ -5,6 +5,9 @@
 #include <iostream>
 #include <map>
 #include <filesystem>
+#include <mutex>
+#include <algorithm>
+#include <chrono>
 #include "common.hpp"
 
 struct msg_complexity {
@@ -31,6 +34,11 @@ private:
     std::vector<double> bloomfilter_exec_times;
     std::map<int, double>compute_breakdown_times;
     std::map<int, struct msg_complexity> msg_complexities;
+    double aggregate_fold_time = 0.0;  // Server share aggregation phases, in ms
+    double aggregate_tree_time = 0.0;
+    std::map<int, std::vector<double>> completion_times;  // Per party, ms after launch, one per repetition
+    std::mutex log_mutex;  // Party threads and query workers log concurrently
+    const Options* options = &g_options;  // Parameters this run is reported against
 
 public:
     enum OPS {
@@ -39,11 +47,13 @@ public:
         BLOOMFILTER_OP,
         COMPUTE_BREAKDOWN,
         COMPUTE_BREAKDOWN_WAITTIME,
-        COMPUTE_MSG_COMPLEXITY
+        COMPUTE_MSG_COMPLEXITY,
+        AGGREGATE_FOLD_OP,
+        AGGREGATE_TREE_OP
     };
 
     ~Stats() {
-        if (g_options.stats) {
+        if (options->stats) {
             output_party_csv();
             if (file.is_open()) file.close();
         }
@@ -54,7 +64,7 @@ public:
 
     Stats(size_t repetitions, const std::string& results_filename)
         : total_repetitions(repetitions), filename(results_filename), fpath(results_filename) {
-        if (!g_options.stats) {
+        if (!options->stats) {
             return;
         }
         // Open file and write CSV header
@@ -68,7 +78,7 @@ public:
     }
 
     Stats(const std::string& filename) : file(filename, std::ios::app), filename(filename), fpath(filename) {
-        if (!g_options.stats) {
+        if (!options->stats) {
             return;
         }
         if (!file.is_open()) {
@@ -79,6 +89,10 @@ public:
         }*/
     }
 
+    // Statistics of one hosted session (see SessionHost); the file is opened on first output
+    Stats(const std::string& filename, const Options& session_options)
+        : total_repetitions(session_options.repetitions), filename(filename), fpath(filename), options(&session_options) {}
+
     Stats& operator=(Stats& other) {
         if (this != &other) {
             execution_times = std::move(other.execution_times);
@@ -91,12 +105,16 @@ public:
             xof_exec_times = std::move(other.xof_exec_times);
             bloomfilter_exec_times = std::move(other.bloomfilter_exec_times);
             compute_breakdown_times = std::move(other.compute_breakdown_times);
+            aggregate_fold_time = other.aggregate_fold_time;
+            aggregate_tree_time = other.aggregate_tree_time;
+            completion_times = std::move(other.completion_times);
+            options = other.options;
         }
         return *this;
     }
     
     void log_result(size_t repetition, double exec_time, bool success) {
-        if (!g_options.stats) {
+        if (!options->stats) {
             return;
         }
         execution_times.push_back(exec_time);
@@ -123,7 +141,7 @@ public:
     }
 
     void print_summary() const {
-        if (!g_options.stats) {
+        if (!options->stats) {
             return;
         }
         std::cout << "Experiment Summary:\n";
@@ -143,24 +161,24 @@ public:
             if (std::filesystem::file_size(fpath) <= 0) {
                 file<<"Set Size, Party Count, Hash Count, Server Side (s), Query Servers (s), Clients (s), Query Servers Message Count, Query Servers Message Size, Client Message Count, Client Message Size\n";
             }
-            file<<g_options.set_size<<", "<<g_options.party_count<<", ";
-            file<<g_options.hash_count<<", ";
+            file<<options->set_size<<", "<<options->party_count<<", ";
+            file<<options->hash_count<<", ";
 
-            auto tot_clients = g_options.party_count - 2;
+            auto tot_clients = options->party_count - 2;
             //Time in seconds
-            file<<(compute_breakdown_times[0]/g_options.repetitions)/1000<<", ";
-            file<<(compute_breakdown_times[1]/g_options.repetitions)/1000<<", ";
+            file<<(compute_breakdown_times[0]/options->repetitions)/1000<<", ";
+            file<<(compute_breakdown_times[1]/options->repetitions)/1000<<", ";
             if (tot_clients <= 0) {
                 file<<0<<", ";
             } else {
-                file<<((compute_breakdown_times[2]/g_options.repetitions)/1000)/tot_clients<<", ";
+                file<<((compute_breakdown_times[2]/options->repetitions)/1000)/tot_clients<<", ";
             }
             //file <<msg_complexities[0].msg_cnt<<", "<<msg_complexities[0].msg_size<<", ";
-            file <<msg_complexities[1].msg_cnt/g_options.repetitions<<", "<<msg_complexities[1].msg_size/g_options.repetitions<<", ";
+            file <<msg_complexities[1].msg_cnt/options->repetitions<<", "<<msg_complexities[1].msg_size/options->repetitions<<", ";
             if (tot_clients <= 0) {
                 file<<0<<", ";
             } else {
-                file <<(msg_complexities[2].msg_cnt/g_options.repetitions)/tot_clients<<", "<<(msg_complexities[2].msg_size/g_options.repetitions)/tot_clients<<"\n";
+                file <<(msg_complexities[2].msg_cnt/options->repetitions)/tot_clients<<", "<<(msg_complexities[2].msg_size/options->repetitions)/tot_clients<<"\n";
             }
             //return;
         }
@@ -201,11 +219,66 @@ public:
         file2<<"Sum: "<<xor_sum<<", "<<xof_sum<<", "<<bloomfilter_sum<< "\n";
         file2<< "Total: "<<xor_exec_times.size()<<", "<<xof_exec_times.size()<<", "<<bloomfilter_exec_times.size()<< "\n";
         file2<< "Average: " << xor_sum/xor_exec_times.size() << ", " << xof_sum/xof_exec_times.size() << ", " << bloomfilter_sum/bloomfilter_exec_times.size() << "\n";
+        file2<< "Aggregation fold (in ms), Aggregation tree (in ms)\n";
+        file2<< aggregate_fold_time << ", " << aggregate_tree_time << "\n";
+        if (!completion_times.empty()) {
+            std::vector<double> clients = completion_tail(2);
+            file2<< "Party completion (in ms): Server max, Querier max, Clients p50, p90, p99, max\n";
+            file2<< completion_tail(0).back() << ", " << completion_tail(1).back() << ", ";
+            for (double q : {0.50, 0.90, 0.99, 1.0}) {
+                file2<< (clients.empty() ? 0.0 : clients[static_cast<size_t>(q * (clients.size() - 1))])
+                     << (q < 1.0 ? ", " : "\n");
+            }
+            /* End-to-end latency: the querier finishes once its result is in */
+            std::vector<double> results = completion_tail(1);
+            file2<< "Querier result latency (in ms): p50, p90, p99, max\n";
+            for (double q : {0.50, 0.90, 0.99, 1.0}) {
+                file2<< results[static_cast<size_t>(q * (results.size() - 1))] << (q < 1.0 ? ", " : "\n");
+            }
+            /* Per party, so slow parties from a speed profile show up by id */
+            file2<< "Party completion by party (in ms): Party, p50, p90, p99, max\n";
+            for (const auto& [party_id, party_times] : completion_times) {
+                std::vector<double> times = party_times;
+                std::sort(times.begin(), times.end());
+                file2<< party_id;
+                for (double q : {0.50, 0.90, 0.99, 1.0}) {
+                    file2<< ", " << times[static_cast<size_t>(q * (times.size() - 1))];
+                }
+                file2<< "\n";
+            }
+        }
         file2.close();
     }
 
+    // Sorted completion times of party 'party_id', or of every party from 2 on when 'party_id' is 2
+    std::vector<double> completion_tail(int party_id) const {
+        std::vector<double> times;
+        for (const auto& [id, party_times] : completion_times) {
+            if (id == party_id || (party_id >= 2 && id >= 2)) {
+                times.insert(times.end(), party_times.begin(), party_times.end());
+            }
+        }
+        std::sort(times.begin(), times.end());
+        if (times.empty() && party_id < 2) times.push_back(0.0);
+        return times;
+    }
+
+    double get_compute_breakdown(int party_id) const {
+        auto it = compute_breakdown_times.find(party_id);
+        return it == compute_breakdown_times.end() ? 0.0 : it->second;
+    }
+
+    double get_aggregation_time(const OPS& op) const {
+        return op == AGGREGATE_TREE_OP ? aggregate_tree_time : aggregate_fold_time;
+    }
+
+    msg_complexity get_msg_complexity(int party_id) const {
+        auto it = msg_complexities.find(party_id);
+        return it == msg_complexities.end() ? msg_complexity{0, 0} : it->second;
+    }
+
     void log_experiment(size_t repetition, bool success) {
-        if (!g_options.stats) {
+        if (!options->stats) {
             return;
         }
         if (file.is_open()) {
@@ -218,7 +291,7 @@ public:
     void log_duration(const std::string& label, 
                       const std::chrono::steady_clock::time_point& start_time, 
                       const std::chrono::steady_clock::time_point& end_time) {
-        if (!g_options.stats) {
+        if (!options->stats) {
             return;
         }
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
@@ -232,10 +305,11 @@ public:
                     int party_id,
                     const std::chrono::steady_clock::time_point& start_time, 
                     const std::chrono::steady_clock::time_point& end_time) {
-        if (!g_options.stats) {
+        if (!options->stats) {
             return;
         }
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        std::lock_guard<std::mutex> lock(log_mutex);
         
         #if 0
         switch (op) {
@@ -283,13 +357,32 @@ public:
                     compute_breakdown_times[2] -=duration;
                 }
                 break;
-            
+            case AGGREGATE_FOLD_OP:
+            case AGGREGATE_TREE_OP: {
+                /* Folds take well under a millisecond; keep microsecond resolution */
+                double ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+                (op == AGGREGATE_FOLD_OP ? aggregate_fold_time : aggregate_tree_time) += ms;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    void log_completion(int party_id,
+                        const std::chrono::steady_clock::time_point& launch_time,
+                        const std::chrono::steady_clock::time_point& finish_time) {
+        if (!options->stats) {
+            return;
         }
+        std::lock_guard<std::mutex> lock(log_mutex);
+        completion_times[party_id].push_back(std::chrono::duration<double, std::milli>(finish_time - launch_time).count());
     }
+
     void log_msg_complexity(int party_id, size_t msg_cnt, size_t msg_size) {
-        if (!g_options.stats) {
+        if (!options->stats) {
             return;
         }
+        std::lock_guard<std::mutex> lock(log_mutex);
         auto mparty_id = party_id;
         if (mparty_id >= 2) {
             mparty_id = 2;
@@ -303,4 +396,6 @@ public:
     }
 };
 
+extern Stats g_stats;
+
 #endif // STATS_HPP
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <thread>
+#include "TaskRuntime.hpp"
+
+ThreadPool& compute_pool() {
+    static ThreadPool pool(std::max<size_t>(1, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+/* Method Definitions for 'FairScheduler' class */
+FairScheduler::FairScheduler(size_t worker_count) {
+    for (size_t i = 0; i < std::max<size_t>(1, worker_count); ++i) {
+        workers.emplace_back([this]() { work(); });
+    }
+}
+
+FairScheduler::~FairScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    condition.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void FairScheduler::submit(size_t tenant, std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queues[tenant].push(std::move(task));
+    }
+    condition.notify_one();
+}
+
+void FairScheduler::work() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stop || !queues.empty(); });
+            if (queues.empty()) {
+                return;
+            }
+            /* First tenant at or after the cursor, wrapping around */
+            auto it = queues.lower_bound(next_tenant);
+            if (it == queues.end()) it = queues.begin();
+            task = std::move(it->second.front());
+            it->second.pop();
+            next_tenant = it->first + 1;
+            if (it->second.empty()) queues.erase(it);
+        }
+        task();
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef TASK_RUNTIME_HPP
+#define TASK_RUNTIME_HPP
+
+#include <cstddef>
+#include <map>
+#include <queue>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "ThreadPool.h"
+
+// Process-wide workers for data-parallel steps (filter encoding, share corruption,
+// zero-share expansion), one per hardware thread. Shared by every simulated party, so the
+// thread count no longer grows with the party count. A task on this pool must never wait
+// on the network or on another task of the same pool.
+ThreadPool& compute_pool();
+
+// Workers shared by several tenants (sessions of a SessionHost). Each tenant has its own
+// FIFO and idle workers take the next task from the tenants in turn, so a session with
+// thousands of queued parties cannot starve a small one. Same rule as compute_pool():
+// tasks must not wait on other tasks of this scheduler.
+class FairScheduler {
+public:
+    explicit FairScheduler(size_t workers);
+    ~FairScheduler();
+
+    void submit(size_t tenant, std::function<void()> task);
+
+private:
+    std::vector<std::thread> workers;
+    std::map<size_t, std::queue<std::function<void()>>> queues; // Tenants with queued tasks
+    size_t next_tenant = 0;                                     // Round-robin position
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stop = false;
+
+    void work();
+};
+
+#endif // TASK_RUNTIME_HPP
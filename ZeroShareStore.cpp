@@ -0,0 +1,105 @@
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include <sys/stat.h>
+#include "ZeroShareStore.hpp"
+
+namespace {
+constexpr uint64_t ZERO_SHARE_MAGIC = 0x3153485A5253504DULL; // "MPSRZHS1"
+
+struct ZeroShareHeader {
+    uint64_t magic;
+    uint64_t session_id;
+    uint64_t party_id;
+    uint64_t byte_count;
+};
+}
+
+/* Method Definitions for 'ZeroShare' class */
+ZeroShare ZeroShare::computed(SimdBytes share) {
+    ZeroShare zero_share;
+    zero_share.byte_count = share.size();
+    zero_share.owned = std::move(share);
+    return zero_share;
+}
+
+ZeroShare ZeroShare::mapped(MappedFile file, size_t offset, size_t byte_count) {
+    ZeroShare zero_share;
+    zero_share.file = std::move(file);
+    zero_share.offset = offset;
+    zero_share.byte_count = byte_count;
+    return zero_share;
+}
+
+const uint8_t* ZeroShare::data() const {
+    return file.is_open() ? file.data() + offset : owned.bytes.data();
+}
+
+size_t ZeroShare::size() const {
+    return byte_count;
+}
+
+bool ZeroShare::is_mapped() const {
+    return file.is_open();
+}
+
+SimdBytes ZeroShare::to_simd_bytes() const {
+    if (!file.is_open()) {
+        return owned;
+    }
+    return SimdBytes::from_bytes(std::vector<uint8_t>(data(), data() + byte_count));
+}
+
+/* Method Definitions for 'ZeroShareStore' class */
+ZeroShareStore::ZeroShareStore(std::string dir) : dir(std::move(dir)) {}
+
+std::string ZeroShareStore::path(size_t session_id, size_t party_id) const {
+    return dir + "/zero_share_s" + std::to_string(session_id) + "_p" + std::to_string(party_id) + ".bin";
+}
+
+void ZeroShareStore::save(size_t session_id, size_t party_id, const SimdBytes& share) const {
+    const std::string final_path = path(session_id, party_id);
+    const std::string tmp_path = final_path + ".tmp";
+    {
+        ZeroShareHeader header{ZERO_SHARE_MAGIC, session_id, party_id, share.size()};
+        MappedFile file = MappedFile::create(tmp_path, sizeof(header) + share.size());
+        std::memcpy(file.data(), &header, sizeof(header));
+        std::memcpy(file.data() + sizeof(header), share.bytes.data(), share.size());
+        file.sync();
+    }
+    if (std::rename(tmp_path.c_str(), final_path.c_str()) != 0) {
+        throw std::runtime_error("ZeroShareStore::save: cannot rename '" + tmp_path + "'");
+    }
+}
+
+std::optional<ZeroShare> ZeroShareStore::load(size_t session_id, size_t party_id, size_t byte_count) const {
+    const std::string file_path = path(session_id, party_id);
+    struct stat st;
+    if (::stat(file_path.c_str(), &st) != 0) {
+        return std::nullopt;
+    }
+
+    MappedFile file = MappedFile::open_read(file_path);
+    ZeroShareHeader header;
+    if (file.size() < sizeof(header)) {
+        return std::nullopt;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != ZERO_SHARE_MAGIC || header.session_id != session_id || header.party_id != party_id ||
+        header.byte_count != byte_count || file.size() != sizeof(header) + byte_count) {
+        std::cout << "ZeroShareStore::load(): '" << file_path << "' does not match this session (share bytes "
+                  << header.byte_count << ", expected " << byte_count << ")\n";
+        return std::nullopt;
+    }
+    return ZeroShare::mapped(std::move(file), sizeof(header), byte_count);
+}
+
+std::optional<ZeroShare> ZeroShareStore::take(size_t session_id, size_t party_id, size_t byte_count) const {
+    std::optional<ZeroShare> share = load(session_id, party_id, byte_count);
+    if (share && std::remove(path(session_id, party_id).c_str()) != 0) {
+        /* The mapping outlives the file; a share that cannot be consumed is not used at all */
+        throw std::runtime_error("ZeroShareStore::take: cannot remove '" + path(session_id, party_id) + "'");
+    }
+    return share;
+}
@@ -0,0 +1,50 @@
+#ifndef ZERO_SHARE_STORE_HPP
+#define ZERO_SHARE_STORE_HPP
+
+#include <string>
+#include <optional>
+#include <cstdint>
+#include "MappedFile.hpp"
+#include "secret_sharing_simd.hpp"
+
+// A party's zero share for one session: either computed inline or mapped from the
+// file written by the offline phase. Either way it is read through data()/size().
+class ZeroShare {
+public:
+    static ZeroShare computed(SimdBytes share);
+    static ZeroShare mapped(MappedFile file, size_t offset, size_t byte_count);
+
+    const uint8_t* data() const;
+    size_t size() const;
+    bool is_mapped() const;
+    SimdBytes to_simd_bytes() const;
+
+private:
+    SimdBytes owned;
+    MappedFile file;
+    size_t offset = 0;
+    size_t byte_count = 0;
+};
+
+// Zero shares precomputed offline, one file per (session, party) in a directory. Files
+// start with a header recording the session, party and share size they were made for.
+class ZeroShareStore {
+public:
+    explicit ZeroShareStore(std::string dir);
+
+    std::string path(size_t session_id, size_t party_id) const;
+
+    // Written to a temporary file and renamed, so a reader never sees a partial share
+    void save(size_t session_id, size_t party_id, const SimdBytes& share) const;
+
+    // Empty if there is no file or it was made for a different session, party or size
+    std::optional<ZeroShare> load(size_t session_id, size_t party_id, size_t byte_count) const;
+    // As load(), but the file is unlinked once mapped: a mask used twice would let the server
+    // XOR the two uploads and cancel it, so each stored share is consumed by one run
+    std::optional<ZeroShare> take(size_t session_id, size_t party_id, size_t byte_count) const;
+
+private:
+    std::string dir;
+};
+
+#endif // ZERO_SHARE_STORE_HPP
@@ -10,85 +10,184 @@
 #include <optional>
 #include <iostream>
 #include <cassert>
+#include <cstring>
+#include <stdexcept>
 #include <memory>
 #include <future>
+#include <functional>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <pthread.h>
 #include "approx_mpsi.hpp"
+#include "common.hpp"
+#include "ThreadPool.h"
+#include "TaskRuntime.hpp"
+#include "ShardLayout.hpp"
 
-extern Stats g_stats;
 
 
 /* Method Definitions for 'ApproximateMpsi' class */
-ApproximateMpsi::ApproximateMpsi(FullMesh& net, size_t minimum_bin_count, size_t hash_count, std::string hash_func, size_t domain_size, size_t set_size /*, Stats& pstats*/)
+ApproximateMpsi::ApproximateMpsi(FullMesh& net, size_t minimum_bin_count, size_t hash_count, std::string hash_func, size_t domain_size, size_t set_size,
+                                 const Options& options, Stats& pstats)
         : network(net),
           bin_count(((minimum_bin_count + 63) / 64) * 64),
           hash_count(hash_count),
           hash_func(hash_func),
           domain_size(domain_size),
-          set_size(set_size)
+          set_size(set_size),
+          options(options),
+          stats(pstats)
           //stats(results_filename)
-           /* stats(pstats)*/
            
            {
             //stats = Stats();
             //g_stats = stats;
           }
 
-std::vector<std::unique_ptr<Party>> ApproximateMpsi::setup_parties(size_t n_parties) {
-    std::vector<std::vector<std::array<uint8_t, RAND_SECRET_SIZE>>> party_seeds(n_parties - 1,
-                                                              std::vector<std::array<uint8_t, RAND_SECRET_SIZE>>(n_parties - 1));
-   
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<uint8_t> dist(0, 255);
+void ApproximateMpsi::use_party_scheduler(FairScheduler& scheduler, size_t tenant) {
+    party_scheduler = &scheduler;
+    this->tenant = tenant;
+}
 
-    for (size_t i = 1; i < n_parties; ++i) {
-        for (size_t j = i + 1; j < n_parties; ++j) {
-            std::array<uint8_t, RAND_SECRET_SIZE> seed{};
-            for (auto& byte : seed) byte = dist(gen);
+/* Senders are parties 1..n_parties-1; the server holds no seeds */
+static CorrelatedSeeds sender_seeds(std::vector<PairKeys>& pair_keys, size_t id, size_t n_parties, size_t seed_count) {
+    return id == 0 ? CorrelatedSeeds() : CorrelatedSeeds(std::move(pair_keys[id - 1]), id, 1, n_parties - 1, seed_count);
+}
 
-            party_seeds[i - 1][j - 1] = seed;
-            party_seeds[j - 1][i - 1] = seed;
-        }
+/* Restrict the calling thread (and the threads it starts) to cores [first, first + count) */
+static void pin_to_cores(size_t first, size_t count) {
+#ifdef __linux__
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    for (size_t c = first; c < first + count; ++c) {
+        CPU_SET(c, &cores);
     }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores) != 0) {
+        std::cerr << "pin_to_cores(): could not pin to cores " << first << ".." << first + count - 1 << "\n";
+    }
+#endif
+}
 
-    party_seeds.insert(party_seeds.begin(), {});
+std::vector<std::unique_ptr<Party>> ApproximateMpsi::setup_parties(size_t n_parties) {
+    /* One seed per other sender, as with pairwise seeds */
+    return setup_parties2(n_parties, n_parties > 2 ? n_parties - 2 : 1);
+}
+
+std::vector<std::unique_ptr<Party>> ApproximateMpsi::setup_parties2(size_t n_parties, size_t seeds_sz_factor, size_t session_id) {
+    /* Senders 1..n_parties-1 derive 'seeds_sz_factor' correlated seeds each from the keys
+       they share pairwise (see CorrelatedSeeds); the server holds none */
+    std::vector<PairKeys> pair_keys = CorrelatedSeeds::deal_pair_keys(1, n_parties - 1);
 
     std::vector<std::unique_ptr<Party>> parties;
     parties.reserve(n_parties);
-    for (const auto& seeds : party_seeds) {
-        parties.push_back(std::make_unique<ApproximateMpsiParty>(network, seeds, bin_count, hash_count, hash_func /*, stats*/));
+    for (size_t id = 0; id < n_parties; ++id) {
+        parties.push_back(std::make_unique<ApproximateMpsiParty>(network, sender_seeds(pair_keys, id, n_parties, seeds_sz_factor),
+                                                                 bin_count, hash_count, hash_func, session_id, options, stats));
     }
     return parties;
 }
 
-std::vector<std::unique_ptr<Party>> ApproximateMpsi::setup_parties2(size_t n_parties, size_t seeds_sz_factor) {
-    //const size_t seeds_sz_factor = 314048; /* Size of the bloom filter*/
-    std::vector<std::vector<std::array<uint8_t, RAND_SECRET_SIZE>>> party_seeds(n_parties, 
-                                                                std::vector<std::array<uint8_t, RAND_SECRET_SIZE>>(seeds_sz_factor));
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<uint8_t> dist(0, 255);
+void ApproximateMpsi::precompute_zero_shares(size_t party_count, size_t repetitions) {
+    for (size_t i = 0; i < repetitions; ++i) {
+        size_t session_id = options.session_id + i;
+        std::cout << "Precomputing zero shares for session " << session_id << "...\n";
+        auto parties = setup_parties2(party_count, set_size*SEEDS_PER_ELEMENT, session_id);
 
-    for (size_t i = 1; i < n_parties; ++i) {
-        party_seeds[i - 1].resize(seeds_sz_factor);
-        for (size_t j = i + 1; j < seeds_sz_factor; ++j) {
-            std::array<uint8_t, RAND_SECRET_SIZE> seed{};
-            for (auto& byte : seed) byte = dist(gen);
+        /* Senders are parties 1..party_count-1; each expands its own seeds */
+        std::vector<std::thread> threads;
+        for (size_t id = 1; id < party_count; id++) {
+            threads.emplace_back([&parties, id]() {
+                static_cast<ApproximateMpsiParty&>(*parties[id]).precompute_zero_share(id);
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+}
 
-            party_seeds[i - 1][j - 1] = seed;
-            //party_seeds[j - 1][i - 1] = seed;
+/* Checked before any party starts: a sender without its share could not send, and the
+   server and queriers would wait on it forever */
+void ApproximateMpsi::require_zero_shares(const std::vector<std::unique_ptr<Party>>& parties, size_t party_count,
+                                          size_t session_id) const {
+    if (options.phase != "online") {
+        return;
+    }
+    for (size_t id = 1; id < party_count; id++) {
+        if (!static_cast<const ApproximateMpsiParty&>(*parties[id]).has_precomputed_zero_share(id)) {
+            throw std::runtime_error("no precomputed zero share for party " + std::to_string(id) +
+                                     ", session " + std::to_string(session_id) + " in " + options.offline_dir +
+                                     " (each is used once; rerun the offline phase)");
         }
     }
+}
 
-    party_seeds.insert(party_seeds.begin(), {});
+void ApproximateMpsi::run_daemon(size_t party_count, size_t epochs) {
+    ShareShape shape;
+    shape.encoding = options.encoding == "fuse" ? "fuse" : "bloom/" + options.bloom_layout;
+    shape.bin_count = bin_count;
+    shape.probe_width = ApproximateMpsiParty::probe_width(options);
+    shape.hash_count = hash_count;
+    shape.set_size = set_size;
+    shape.party_count = party_count;
+    ShareEpochServer server(options.snapshot_dir, shape);
+    size_t first_epoch = options.session_id;
+    if (server.restore(options.snapshot_verify, options.snapshot_populate)) {
+        /* The restored epoch is live already; ingesting resumes after it */
+        first_epoch = server.current()->epoch() + 1;
+    } else {
+        std::cout << "No persisted aggregate; queries wait for the first epoch\n";
+    }
 
-    std::vector<std::unique_ptr<Party>> parties;
-    parties.reserve(n_parties);
-    for (const auto& seeds : party_seeds) {
-        parties.push_back(std::make_unique<ApproximateMpsiParty>(network, seeds, bin_count, hash_count, hash_func /*, stats*/));
+    /* Clients keep their sets across epochs and only re-share them under fresh masks, so a
+       query is answered correctly by whichever epoch is live when it arrives */
+    auto inputs = generate_inputs(party_count);
+    /* Queries reach the daemon on their own endpoint, so they never queue behind shares */
+    const size_t query_endpoint = party_count;
+    for (size_t e = 0; e < epochs; ++e) {
+        const size_t epoch = first_epoch + e;
+        std::cout << "Daemon epoch " << epoch << ": ingesting client shares...\n";
+        auto parties = setup_parties2(party_count, set_size*SEEDS_PER_ELEMENT, epoch);
+        require_zero_shares(parties, party_count, epoch);
+        auto& server_party = static_cast<ApproximateMpsiParty&>(*parties[0]);
+
+        std::vector<std::optional<Set>> outputs(party_count);
+        size_t served_epoch = 0;
+        std::vector<std::thread> threads;
+        threads.emplace_back([&]() {
+            server.publish(epoch, server_party.aggregate_shares(0, server_party.aggregation_children(0, party_count)));
+        });
+        threads.emplace_back([&]() {
+            /* Served from the live epoch while this one ingests; only a daemon that restored
+               nothing waits, for its first epoch. The snapshot stays valid through a publish */
+            std::shared_ptr<const EpochShare> snapshot = server.wait_current();
+            served_epoch = snapshot->epoch();
+            std::cout << "Daemon epoch " << epoch << ": answering queries from epoch " << served_epoch << "\n";
+            server_party.answer_queries(query_endpoint, snapshot->data(), snapshot->size());
+        });
+        for (size_t id = 1; id < party_count; id++) {
+            threads.emplace_back([&, id]() {
+                auto& party = static_cast<ApproximateMpsiParty&>(*parties[id]);
+                network.mark_active(id);
+                party.run_client_approx(id, *inputs[id], network.get_channels(id));
+                if (id <= options.queriers) {
+                    outputs[id] = party.query_server(id, *inputs[id], query_endpoint);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        if (served_epoch < first_epoch) {
+            /* A restored aggregate was built from an earlier run's sets, not these */
+            std::cout << "Daemon epoch " << epoch << ": answered from restored epoch " << served_epoch
+                      << "; not validated against this run's sets\n";
+            continue;
+        }
+        std::cout << "Validating Results = " << validate_outputs(inputs, outputs) << "\n";
     }
-    return parties;
 }
 
 std::vector<Set> ApproximateMpsi::gen_sets_with_uniform_intersection(size_t n_parties, size_t set_size, size_t domain_size) {
@@ -114,6 +213,16 @@ std::vector<Set> ApproximateMpsi::gen_sets_with_uniform_intersection(size_t n_pa
             unique_elements.insert(rng() % domain_size);
         }
 
+        if (options.element_type == "bytes") {
+            /* Byte-string keys: the same numbers rendered as identifiers, packed in one arena */
+            auto keys = std::make_shared<ByteStringArena>();
+            keys->reserve(unique_elements.size(), unique_elements.size() * 32);
+            for (size_t element : unique_elements) {
+                keys->push_back("user" + std::to_string(element) + "@example.org");
+            }
+            sets.emplace_back(Set::from_byte_strings(std::move(keys), ByteStringArena::derive_key(FINGERPRINT_KEY_CONTEXT)));
+            continue;
+        }
         sets.emplace_back(Set(unique_elements));
     }
 
@@ -158,24 +267,77 @@ bool ApproximateMpsi::validate_outputs(
     return expected_intersection == actual_intersection;
 }
 
-void ApproximateMpsi::evaluate(const std::string& experiment_name, size_t party_count,
+size_t ApproximateMpsi::evaluate(const std::string& experiment_name, size_t party_count,
                                 const FullMesh& network_description, size_t repetitions) {
     //Stats stats(results_filename); //experiment_name + ".csv");  // Initialize Stats to log CSV output
 
-    for (size_t i = 0; i < repetitions; ++i) {
-        std::cout << "Running repetition " << (i + 1) << " of " << repetitions << "...\n";
+    const size_t lanes = std::min(std::max<size_t>(1, options.concurrent_repetitions), repetitions);
+    if (lanes <= 1) {
+        return run_repetitions(party_count, 0, 1, repetitions);
+    }
 
-        // Step 1: Generate inputs (randomized sets with uniform intersection)
-        std::cout << "Generating inputs...\n";
-        auto inputs = generate_inputs(party_count);
+    /* Concurrent repetitions: lane l runs repetitions l, l + lanes, ... on its own network
+       namespace, pinned to its own slice of the cores. Threads inherit the creating thread's
+       affinity, so the shared compute pool is started before any lane is pinned. */
+    compute_pool();
+    const size_t cores = std::thread::hardware_concurrency();
+    /* Lane views build their Channels here, before any lane sends: the Channels constructor
+       touches the static legacy network without its mutex */
+    std::vector<std::unique_ptr<FullMesh>> lane_networks;
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        lane_networks.push_back(network_description.lane_view(lane + 1));
+    }
+    std::vector<std::thread> lane_threads;
+    std::atomic<size_t> successes{0};
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        lane_threads.emplace_back([&, lane]() {
+            if (cores >= lanes) {
+                pin_to_cores(lane * (cores / lanes), cores / lanes);
+            }
+            ApproximateMpsi lane_protocol(*lane_networks[lane], bin_count, hash_count, hash_func, domain_size, set_size, options, stats);
+            lane_protocol.party_scheduler = party_scheduler;
+            lane_protocol.tenant = tenant;
+            successes += lane_protocol.run_repetitions(party_count, lane, lanes, repetitions);
+        });
+    }
+    for (auto& thread : lane_threads) {
+        thread.join();
+    }
+    return successes;
+}
 
-        // Step 2: Set up network communication (FullMesh)
-        std::cout << "Setting up network...\n";
-        const FullMesh& network = network_description;
+size_t ApproximateMpsi::run_repetitions(size_t party_count, size_t first, size_t stride, size_t repetitions) {
+    /* Kept across repetitions: the worker pool and, with --reuse-parties, inputs and parties */
+    std::unique_ptr<ThreadPool> party_pool;
+    if (options.party_workers > 0 && !party_scheduler) {
+        party_pool = std::make_unique<ThreadPool>(options.party_workers);
+    }
+    std::vector<std::optional<Set>> inputs;
+    std::vector<std::unique_ptr<Party>> parties;
+    size_t successes = 0;
 
-        // Step 3: Set up parties
-        std::cout << "Setting up parties...\n";
-        auto parties = setup_parties2(party_count+1, set_size*40);
+    for (size_t i = first; i < repetitions; i += stride) {
+        std::cout << "Running repetition " << (i + 1) << " of " << repetitions << "...\n";
+        const size_t session_id = options.session_id + i;
+
+        if (!options.reuse_parties || parties.empty()) {
+            // Step 1: Generate inputs (randomized sets with uniform intersection)
+            std::cout << "Generating inputs...\n";
+            inputs = generate_inputs(party_count);
+
+            // Step 2: Set up parties
+            std::cout << "Setting up parties...\n";
+            parties = setup_parties2(party_count, set_size*SEEDS_PER_ELEMENT, session_id);
+        } else {
+            /* Same inputs and party objects; only the session and its seeds are new */
+            std::vector<PairKeys> pair_keys = CorrelatedSeeds::deal_pair_keys(1, parties.size() - 1);
+            for (size_t id = 0; id < parties.size(); ++id) {
+                static_cast<ApproximateMpsiParty&>(*parties[id]).begin_session(
+                    session_id, sender_seeds(pair_keys, id, parties.size(), set_size*SEEDS_PER_ELEMENT));
+            }
+        }
+
+        require_zero_shares(parties, party_count, session_id);
 
         // Step 4: Run protocol for all parties
         std::cout << "Running protocol for all parties...\n";
@@ -185,7 +347,13 @@ void ApproximateMpsi::evaluate(const std::string& experiment_name, size_t party_
         std::vector<std::optional<Set>> v_outputs;
         outputs.reserve(parties.size());
 
+        std::vector<std::future<std::optional<Set>>> completions;
+        completions.reserve(parties.size());
+        const auto launch_time = std::chrono::steady_clock::now();
+
         std::vector<std::thread> threads;
+        /* Parties that only send never block, so a fixed pool can run any number of them;
+           parties that wait on messages keep their own thread */
         /*
         std::vector<std::promise<std::optional<Set>>> promises;
         std::vector<std::future<std::optional<Set>>> futures;
@@ -207,8 +375,7 @@ void ApproximateMpsi::evaluate(const std::string& experiment_name, size_t party_
             //thread_data *th_data = new thread_data;
             std::unique_ptr<thread_data> th_data = std::make_unique<thread_data>();
             th_data->id = id;
-            th_data->is_completed = false;
-            th_data->output = std::nullopt;
+            completions.push_back(th_data->result.get_future());
             //outputs.push_back(th_data);
             outputs.push_back(std::move(th_data)); // now only 'outputs.back()' owns it
             thread_data* th_data_ptr = outputs.back().get(); // raw pointer is safe here 
@@ -220,28 +387,37 @@ void ApproximateMpsi::evaluate(const std::string& experiment_name, size_t party_
                 parties[p_id]->run(p_id, party_count, *inputs[p_id], network.get_channels(p_id), th_data);
             });*/
             
-            threads.emplace_back([&, th_data_ptr /*th_data = std::move(th_data)*/]() mutable {
+            auto run_party = [&, th_data_ptr /*th_data = std::move(th_data)*/]() mutable {
                 auto p_id = th_data_ptr->id;
                 std::cout<<"ApproximateMpsi::evaluate():Running (2) party id ="<<p_id<<", party count ="<<party_count<<"\n";
-                parties[p_id]->run(p_id, party_count, inputs[p_id], network.get_channels(p_id), th_data_ptr /*th_data.get()*/);
-            });
+                try {
+                    parties[p_id]->run(p_id, party_count, inputs[p_id], network.get_channels(p_id), th_data_ptr /*th_data.get()*/);
+                } catch (...) {
+                    /* run() sets the result last, so it cannot have been set yet */
+                    th_data_ptr->result.set_exception(std::current_exception());
+                }
+            };
+            const bool send_only = !static_cast<ApproximateMpsiParty&>(*parties[id]).receives(id, party_count);
+            if (send_only && party_scheduler) {
+                party_scheduler->submit(tenant, run_party);
+            } else if (send_only && party_pool) {
+                party_pool->enqueue(run_party);
+            } else {
+                threads.emplace_back(run_party);
+            }
             //auto end_time = std::chrono::steady_clock::now();
             //stats.log_duration(Stats::OPS::COMPUTE_BREAKDOWN, id, start_time, end_time);
             //outputs.push_back(std::move(out));
         }
-        std::cout<<"ApproximateMpsi::evaluate():outputs size="<<outputs.size()<<"\n";
-        // Wait for all parties to finish
-        while (true) {
-            bool all_completed = true;
-            //for (size_t id = 0; id < party_count-2; id++) {
-            for (size_t id = 0; id < party_count; id++) {
-                if (!outputs[id]->is_completed) {
-                    all_completed = false;
-                    break;
-                }
-            }
-            if (all_completed) break;
+        /* Shards 1.. are server roles without secrets; they run on the server's party object */
+        for (size_t shard = 1; shard < options.server_shards; shard++) {
+            threads.emplace_back([&, shard]() {
+                static_cast<ApproximateMpsiParty&>(*parties[0]).run_shard(shard, party_count);
+            });
         }
+        std::cout<<"ApproximateMpsi::evaluate():outputs size="<<outputs.size()<<"\n";
+        // Wait for all parties to finish: blocking on each party's future uses no CPU, and a
+        // party that threw rethrows here
         //for (size_t id = 0; id < party_count-1; id++) {
         //for (size_t id = 0; id < party_count-2; id++) {
         for (size_t id = 0; id < party_count; id++) {
@@ -251,54 +427,165 @@ void ApproximateMpsi::evaluate(const std::string& experiment_name, size_t party_
                 std::cout << "Waiting for party " << id << " to finish...\n";
             }
             auto out = futures[id].get();*/
-            auto out = outputs[id]->output;
+            auto out = completions[id].get();
+            stats.log_completion(id, launch_time, outputs[id]->finished);
             v_outputs.push_back(std::move(out));
         }
         for (auto& thread : threads) {
             thread.join(); // Ensure all parties complete
         }
+        if (options.delta_churn > 0) {
+            /* Clients report their post-update sets; validate against those */
+            for (size_t id = 2; id < party_count; id++) {
+                if (v_outputs[id].has_value()) {
+                    inputs[id] = v_outputs[id];
+                }
+            }
+        }
+        /* Senders the server left out of the round are not part of this result; party 1's
+           set still bounds it, since party 1 only queries its own elements */
+        std::vector<std::optional<Set>> participants = inputs;
+        const auto& excluded = static_cast<ApproximateMpsiParty&>(*parties[0]).excluded_senders();
+        for (size_t id : excluded) {
+            if (id != 1) participants[id].reset();
+        }
+        if (options.round_deadline_ms > 0) {
+            /* generate_inputs() makes one set more than there are parties; only parties count here */
+            participants.resize(std::min(participants.size(), party_count));
+            network.discard_pending();
+            std::cout << "Result latency = " << std::chrono::duration<double, std::milli>(outputs[1]->finished - launch_time).count()
+                      << " ms, excluded senders = " << excluded.size() << "\n";
+            if (static_cast<ApproximateMpsiParty&>(*parties[0]).round_aborted()) {
+                std::cout << "Round aborted: fewer than " << options.min_on_time_senders << " senders on time\n";
+                std::cout << "Validating Results = 0\n";
+                continue;
+            }
+        }
         // Step 5: Validate outputs
         std::cout << "Validating outputs...\n";
-        bool success = validate_outputs(inputs, v_outputs);
+        bool success = validate_outputs(participants, v_outputs);
         std::cout << "Validating Results = "<<success<<"\n";
+        successes += success;
         //stats.log_experiment(i + 1, success);  // Log success/failure to CSV
     }
 
     //return stats;
+    return successes;
 }
 
 /* Method Definitions for 'ApproximateMpsiParty' class */
-ApproximateMpsiParty::ApproximateMpsiParty(FullMesh& net, std::vector<std::array<uint8_t, RAND_SECRET_SIZE>> seeds, size_t bin_count, size_t hash_count, std::string hash_func /*, Stats& pstats*/)
-    : network(net), seeds(std::move(seeds)), bin_count(bin_count), hash_count(hash_count), hash_func(hash_func)/*, stats(pstats)*/ {}
+ApproximateMpsiParty::ApproximateMpsiParty(FullMesh& net, CorrelatedSeeds seeds, size_t bin_count, size_t hash_count, std::string hash_func, size_t session_id,
+                                           const Options& options, Stats& pstats)
+    : network(net), seeds(std::move(seeds)), bin_count(bin_count), hash_count(hash_count), hash_func(hash_func), stats(pstats), options(options), session_id(session_id) {}
+
+void ApproximateMpsiParty::begin_session(size_t session_id, CorrelatedSeeds seeds) {
+    this->session_id = session_id;
+    this->seeds = std::move(seeds);
+    updated_input.reset();
+    share_units = 0;
+    excluded.clear();
+    aborted = false;
+}
+
+const std::vector<size_t>& ApproximateMpsiParty::excluded_senders() const {
+    return excluded;
+}
+
+bool ApproximateMpsiParty::round_aborted() const {
+    return aborted;
+}
+
+/* Share size for the active encoding; the zero share does not depend on the input set */
+size_t ApproximateMpsiParty::zero_share_byte_count() const {
+    if (options.encoding == "fuse") {
+        return BinaryFuseFilter(options.set_size, options.fuse_fingerprint_bytes, RANDOM_SEED).byte_size();
+    }
+    if (options.share_width > 0) {
+        return options.share_width * bin_count;
+    }
+    return SHARE_BYTE_COUNT * bin_count;
+}
+
+void ApproximateMpsiParty::precompute_zero_share(size_t id) {
+    auto start_time = std::chrono::steady_clock::now();
+    SimdBytes share = seeds.expand(zero_share_byte_count());
+    ZeroShareStore(options.offline_dir).save(session_id, id, share);
+    auto end_time = std::chrono::steady_clock::now();
+    std::cout<<"ApproximateMpsiParty::precompute_zero_share(): party "<<id<<", session "<<session_id
+             <<", "<<share.size()<<" bytes in "
+             <<std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count()<<" ms\n";
+}
+
+bool ApproximateMpsiParty::has_precomputed_zero_share(size_t id) const {
+    return ZeroShareStore(options.offline_dir).load(session_id, id, zero_share_byte_count()).has_value();
+}
+
+/* Online phase maps the share written offline; otherwise expand the seeds now */
+ZeroShare ApproximateMpsiParty::acquire_zero_share(size_t id, size_t byte_count) {
+    if (options.phase == "online") {
+        std::optional<ZeroShare> stored = ZeroShareStore(options.offline_dir).take(session_id, id, byte_count);
+        if (stored) {
+            return std::move(*stored);
+        }
+        /* The offline run dealt other pair keys, so a share expanded here
+           would not cancel against the other parties' stored shares */
+        throw std::runtime_error("acquire_zero_share: no precomputed share of " + std::to_string(byte_count) +
+                                 " bytes for party " + std::to_string(id) + ", session " +
+                                 std::to_string(session_id) + " in " + options.offline_dir);
+    }
+    return ZeroShare::computed(seeds.expand(byte_count));
+}
+
+/* Share bytes behind one query index: bin-aligned shares hold share_width bytes per bin,
+   legacy shares (--share-width 0, any layout) one byte per filter bit, as
+   conditionally_corrupt_share_parallel() lays them out, and fuse shares one fingerprint per cell */
+size_t ApproximateMpsiParty::probe_width(const Options& options) {
+    if (options.encoding == "fuse") return options.fuse_fingerprint_bytes;
+    if (options.share_width > 0) return options.share_width;
+    return 1;
+}
+
+size_t ApproximateMpsiParty::probe_width() const {
+    return probe_width(options);
+}
 
 std::vector<bool> ApproximateMpsiParty::compute_query_results(
     size_t id,
     const std::vector<std::vector<size_t>>& query_patterns, 
-    const SimdBytes& aggregated_share) 
+    const uint8_t* aggregated_share,
+    size_t share_size,
+    size_t begin,
+    size_t end) 
 {
     std::vector<bool> results;
-    
-    // Convert aggregated share into individual byte chunks
-    std::vector<std::array<uint8_t, SHARE_BYTE_COUNT>> shares = aggregated_share.to_byte_chunks<SHARE_BYTE_COUNT>();
+    end = std::min(end, query_patterns.size());
+    begin = std::min(begin, end);
 
-    auto start_time = std::chrono::steady_clock::now();
-    for (const auto& query_pattern : query_patterns) {
-        std::array<uint8_t, SHARE_BYTE_COUNT> xor_result = {0};
+    /* In the blocked layout all indices of a pattern fall in one block, so prefetching the
+       next pattern's first bin covers its whole probe */
+    const size_t width = probe_width();
+    const uint8_t* share = aggregated_share;
+    const size_t bin_total = share_size / width;
+    results.reserve(end - begin);
 
-        // XOR all shares corresponding to query indices
-        for (size_t index : query_pattern) {
-            for (size_t i = 0; i < SHARE_BYTE_COUNT; i++) {
-                xor_result[i] ^= shares[index][i];
+    auto start_time = std::chrono::steady_clock::now();
+    std::array<uint8_t, SHARE_BYTE_COUNT> xor_result;
+    for (size_t q = begin; q < end; q++) {
+        if (bin_total > 0 && q + 1 < end && !query_patterns[q + 1].empty()) {
+            _mm_prefetch(reinterpret_cast<const char*>(share + (query_patterns[q + 1][0] % bin_total) * width), _MM_HINT_T0);
+        }
+        std::fill_n(xor_result.begin(), width, 0);
+        for (size_t index : query_patterns[q]) {
+            assert(index < bin_total);
+            const uint8_t* bin = share + index * width;
+            for (size_t i = 0; i < width; i++) {
+                xor_result[i] ^= bin[i];
             }
         }
-
-        // If XOR result is all zero, it’s a match
-        results.push_back(std::all_of(xor_result.begin(), xor_result.end(), [](uint8_t b) { return b == 0; }));
+        results.push_back(std::all_of(xor_result.begin(), xor_result.begin() + width, [](uint8_t b) { return b == 0; }));
     }
     auto end_time = std::chrono::steady_clock::now();
-    g_stats.log_duration(Stats::OPS::XOR_OP, id, start_time, end_time);
-    //auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
- 
+    stats.log_duration(Stats::OPS::XOR_OP, id, start_time, end_time);
     return results;
 }
 
@@ -312,63 +599,212 @@ std::vector<std::vector<size_t>> ApproximateMpsiParty::generate_query_patterns(c
     return query_patterns;
     */
 
+    if (options.encoding == "fuse") {
+        /* Three cells per element, in input.ordered_elements() order like the results */
+        BinaryFuseFilter filter(options.set_size, options.fuse_fingerprint_bytes, RANDOM_SEED);
+        for (const auto& digest : input.element_digests(hash_func)) {
+            query_patterns.push_back(filter.positions(digest));
+        }
+        return query_patterns;
+    }
+
    return input.bloom_filter_indices(bin_count, hash_count, hash_func);
 }
 
-Set ApproximateMpsiParty::extract_intersection(
-    const Set& input, 
-    const std::vector<bool>& query_results) 
+std::vector<std::vector<uint8_t>> ApproximateMpsiParty::encode_query_batches(const Set& input, size_t batch_count,
+                                                                          std::vector<size_t>& batch_sizes) {
+    /* Batches are consecutive slices in element order, so the concatenated results line up
+       with extract_intersection() */
+    std::vector<std::array<uint64_t, 2>> digests;
+    std::vector<std::vector<size_t>> query_patterns;
+    if (options.query_encoding == "digest") {
+        digests = input.element_digests(hash_func);
+    } else {
+        query_patterns = generate_query_patterns(input);
+    }
+    const size_t total = options.query_encoding == "digest" ? digests.size() : query_patterns.size();
+    const size_t per_batch = (total + batch_count - 1) / batch_count;
+
+    std::vector<std::vector<uint8_t>> batches;
+    batch_sizes.clear();
+    for (size_t b = 0; b < batch_count; ++b) {
+        size_t begin = std::min(b * per_batch, total);
+        size_t end = std::min(begin + per_batch, total);
+        batch_sizes.push_back(end - begin);
+        if (options.query_encoding == "digest") {
+            batches.push_back(encode_query_digests({digests.begin() + begin, digests.begin() + end}));
+        } else if (options.query_encoding == "packed") {
+            batches.push_back(encode_packed_query({query_patterns.begin() + begin, query_patterns.begin() + end}));
+        } else {
+            batches.push_back(FullMesh::encode_index_patterns({query_patterns.begin() + begin, query_patterns.begin() + end}));
+        }
+    }
+    return batches;
+}
+
+std::vector<std::vector<size_t>> ApproximateMpsiParty::decode_query(const std::vector<uint8_t>& message, size_t bin_total) const {
+    if (options.query_encoding == "indices") {
+        return FullMesh::decode_index_patterns(message);
+    }
+    if (options.query_encoding == "packed") {
+        return decode_packed_query(message);
+    }
+
+    /* Same positions generate_query_patterns() derives from each digest; the filter size
+       is the number of bins in the aggregated share */
+    std::vector<std::array<uint64_t, 2>> digests = decode_query_digests(message);
+    std::vector<std::vector<size_t>> query_patterns(digests.size());
+    if (options.encoding == "fuse") {
+        BinaryFuseFilter filter(options.set_size, options.fuse_fingerprint_bytes, RANDOM_SEED);
+        for (size_t i = 0; i < digests.size(); ++i) {
+            query_patterns[i] = filter.positions(digests[i]);
+        }
+    } else {
+        for (size_t i = 0; i < digests.size(); ++i) {
+            Set::blocked_bloom_indices(digests[i], bin_total, hash_count, options.bloom_block_bins, query_patterns[i]);
+        }
+    }
+    return query_patterns;
+}
+
+size_t ApproximateMpsiParty::extract_intersection(const size_t* elements, size_t count,
+                                                  const uint8_t* result_bits, std::vector<size_t>& matches)
 {
-    Set intersection;
+    /* Result bit i (LSB first, as FullMesh packs std::vector<bool>) belongs to elements[i].
+       Scan 64 bits at a time and jump between set bits with a trailing-zero count (rep bsf,
+       executed as tzcnt on BMI hardware) */
+    const size_t first = matches.size();
+    for (size_t base = 0; base < count; base += 64) {
+        const size_t bits = std::min<size_t>(64, count - base);
+        uint64_t word = 0;
+        std::memcpy(&word, result_bits + base / 8, (bits + 7) / 8);
+        if (bits < 64) word &= (uint64_t{1} << bits) - 1;
+        while (word != 0) {
+            matches.push_back(elements[base + static_cast<size_t>(__builtin_ctzll(word))]);
+            word &= word - 1;
+        }
+    }
+    return matches.size() - first;
+}
+
+bool ApproximateMpsiParty::receives(size_t id, size_t n_parties) const {
+    /* With a round deadline every sender waits for the server to close the round */
+    return id == 0 || id <= options.queriers || options.round_deadline_ms > 0 ||
+           !aggregation_children(id, n_parties).empty();
+}
+
+/* Aggregation topology. Flat: every sender uploads to the server. With a fan-in F the
+   parties form an F-ary heap rooted at the server: parent(id) = (id - 1) / F, and
+   each party receives from ids F*id + 1 .. F*id + F */
+size_t ApproximateMpsiParty::aggregation_parent(size_t id) const {
+    return options.aggregation_fan_in == 0 ? 0 : (id - 1) / options.aggregation_fan_in;
+}
 
-    auto elements = input.get_elements();
-    auto it = elements.begin();
-    for (size_t i = 0; i < elements.size(); i++, ++it) {
-        if (query_results[i]) {
-            intersection.insert(*it);
+std::vector<size_t> ApproximateMpsiParty::aggregation_children(size_t id, size_t n_parties) const {
+    std::vector<size_t> children;
+    if (options.aggregation_fan_in == 0) {
+        if (id == 0) {
+            for (size_t i = 1; i < n_parties; ++i) children.push_back(i);
         }
+        return children;
+    }
+    for (size_t i = id * options.aggregation_fan_in + 1; i <= (id + 1) * options.aggregation_fan_in && i < n_parties; ++i) {
+        children.push_back(i);
     }
+    return children;
+}
 
-    return intersection;
+SimdBytes ApproximateMpsiParty::aggregate_shares(size_t id, const std::vector<size_t>& senders,
+                                                 std::chrono::steady_clock::time_point deadline, std::vector<size_t>* late) {
+    // Receive the senders' shares, folding each into one accumulator in arrival order.
+    // Whatever else is already queued is drained with it and folded as one batch, split
+    // by bin range across the aggregation threads.
+    AggregationEngine engine(options.aggregation_threads);
+    ShareStreamAggregator aggregator(senders.size(), &engine);
+    std::unordered_map<size_t, size_t> slot;  // Sender id -> aggregator index
+    for (size_t i = 0; i < senders.size(); ++i) {
+        slot[senders[i]] = i;
+    }
+    const bool chunked = options.stream_chunk_bins > 0;
+    std::vector<std::vector<uint8_t>> batch;
+    std::vector<size_t> batch_senders;
+    std::vector<size_t> pending;
+    while (!aggregator.all_complete()) {
+        pending.clear();
+        for (size_t i = 0; i < senders.size(); ++i) {
+            if (!aggregator.complete(i)) pending.push_back(senders[i]);
+        }
+        batch.resize(1);
+        size_t from = 0;
+        if (!late || pending.size() == senders.size()) {
+            /* A round stays open until its first share is in */
+            from = network.receive_any_into(id, pending, batch[0]);
+        } else if (!network.receive_any_until(id, pending, deadline, batch[0], from)) {
+            break;  // Round closed; whoever is still pending is late
+        }
+        batch_senders.assign(1, slot[from]);
+
+        /* At most one message per sender and pass: a sender's next message may already be
+           past its share (a delta), and completion is only known after the batch is added */
+        std::vector<uint8_t> message;
+        for (size_t sender : pending) {
+            if (sender != from && network.try_receive(id, sender, message)) {
+                batch.push_back(std::move(message));
+                batch_senders.push_back(slot[sender]);
+            }
+        }
+        aggregator.add_batch(batch_senders, batch, chunked, options.aggregation_tree);
+        for (auto& buffer : batch) {
+            network.recycle(std::move(buffer));
+        }
+    }
+    if (late) {
+        for (size_t i = 0; i < senders.size(); ++i) {
+            if (!aggregator.complete(i)) late->push_back(senders[i]);
+        }
+    }
+    SimdBytes aggregated_share = std::move(aggregator.aggregate());
+    auto aggregation_start = std::chrono::steady_clock::now();
+    stats.log_duration(Stats::OPS::AGGREGATE_FOLD_OP, id, aggregation_start, aggregation_start + aggregator.fold_time());
+    stats.log_duration(Stats::OPS::AGGREGATE_TREE_OP, id, aggregation_start, aggregation_start + aggregator.tree_time());
+    return aggregated_share;
 }
 
 void ApproximateMpsiParty::run_server_approx(size_t id, size_t n_parties, Channels& channels) {
     auto start_time = std::chrono::steady_clock::now();
 
-    // Receive all clients' shares
-    std::vector<SimdBytes> received_shares;
-    for (size_t i = 1; i < n_parties; ++i) {
-        /*auto data = channels.receive(i);*/
-        auto data = network.receive(id, i);
-        if (data.size() > 0) {
-            //received_shares.push_back(SimdBytes::from_bytes(channels.receive(i)));
-            received_shares.push_back(SimdBytes::from_bytes(data));
-        }
+    if (options.server_shards > 1) {
+        run_shard(0, n_parties);
+        return;
     }
-    std::cout<<"ApproximateMpsiParty::run_server_approx():received share size="<<received_shares.size()<<"\n";
-    // Aggregate shares
+
     SimdBytes aggregated_share;
-    if (received_shares.size() > 0) {
-        aggregated_share = received_shares[0];
-        for (size_t i = 1; i < received_shares.size(); ++i) {
-            aggregated_share ^= received_shares[i];
+    if (options.round_deadline_ms > 0) {
+        /* Shares are taken in arrival order until the deadline; late senders are left out */
+        const auto deadline = start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                               std::chrono::duration<double, std::milli>(options.round_deadline_ms));
+        std::vector<size_t> late;
+        aggregated_share = aggregate_shares(id, aggregation_children(id, n_parties), deadline, &late);
+        close_round(id, n_parties, late, aggregated_share);
+        if (aborted) {
+            return;  // No aggregate to answer queries from
         }
+    } else {
+        aggregated_share = aggregate_shares(id, aggregation_children(id, n_parties));
     }
 
     std::cout<<"ApproximateMpsiParty::run_server_approx():aggregated share size="<<aggregated_share.to_bytes().size()<<"\n";
-    // Receive query patterns from the querier (id = 1)
-    std::vector<std::vector<size_t>> query_patterns;
-    /* channels.receive(1, query_patterns); */
-    network.receive(id, 1, query_patterns);
 
-    std::cout<<"ApproximateMpsiParty::run_server_approx():query pattern size="<<query_patterns.size()<<"\n";
-    // Compute results
-    std::vector<bool> results = compute_query_results(id, query_patterns, aggregated_share);
-
-    std::cout<<"ApproximateMpsiParty::run_server_approx():result size (compute_query_results)="<<results.size()<<"\n";
-    // Send results to the querier (id = 1)
-    /* channels.send(1, results); */
-    network.send(id, 1, results);
+    if (options.delta_churn > 0) {
+        /* Incremental session: patch the aggregate with each client's delta in place */
+        for (size_t i = 2; i < n_parties; ++i) {
+            ShareDelta delta = ShareDelta::deserialize(network.receive(id, i));
+            apply_share_delta(aggregated_share, delta);
+        }
+        std::cout<<"ApproximateMpsiParty::run_server_approx():applied "<<n_parties - 2<<" share deltas\n";
+    }
+    // Answer every query batch of every querier (ids 1..queriers) against this one aggregate
+    answer_queries(id, aggregated_share.bytes.data(), aggregated_share.size());
 
     // Log execution time
     auto end_time = std::chrono::steady_clock::now();
@@ -376,26 +812,303 @@ void ApproximateMpsiParty::run_server_approx(size_t id, size_t n_parties, Channe
     std::cout<<"ApproximateMpsiParty::run_server_approx():"<<start_time.time_since_epoch().count()<<", "<<end_time.time_since_epoch().count()<<"\n";
 }
 
+/* Round close: every sender learns who missed the deadline. Each sender still in the round
+   then returns its self-mask together with the seeds it shares with the late ones
+   (CorrelatedSeeds::expand_pairs); XORing those in cancels the self-masks and what the
+   missing zero shares would have cancelled, so the aggregate is the zero-sharing of the
+   senders that made it. A late share that arrives anyway keeps its self-mask, which its
+   sender never returns, so no set of corrections unmasks it. With fewer than
+   min_on_time_senders on time the round is aborted and no sender returns anything: the
+   aggregate of one sender is that sender's filter. Corrections are awaited without a
+   deadline: those senders have just shown they are up.
+   The server is trusted to send every sender the same list. One that told a late sender
+   it was on time and everyone else that it was late would get both its self-mask and the
+   corrections for it; the senders do not cross-check the list. */
+void ApproximateMpsiParty::close_round(size_t id, size_t n_parties, const std::vector<size_t>& late, SimdBytes& aggregated_share) {
+    std::vector<size_t> on_time;
+    for (size_t sender = 1; sender < n_parties; ++sender) {
+        if (std::find(late.begin(), late.end(), sender) == late.end()) on_time.push_back(sender);
+    }
+    aborted = on_time.size() < options.min_on_time_senders;
+
+    /* [aborted, late sender ids...] */
+    std::vector<uint8_t> message((late.size() + 1) * sizeof(uint64_t));
+    uint64_t status = aborted;
+    std::memcpy(message.data(), &status, sizeof(status));
+    for (size_t i = 0; i < late.size(); ++i) {
+        uint64_t sender = late[i];
+        std::memcpy(message.data() + (i + 1) * sizeof(uint64_t), &sender, sizeof(sender));
+    }
+    for (size_t sender = 1; sender < n_parties; ++sender) {
+        network.send(id, sender, message);
+    }
+    excluded = late;
+    if (aborted) {
+        std::cout<<"ApproximateMpsiParty::close_round(): aborted, "<<on_time.size()<<" of "<<n_parties - 1
+                 <<" senders on time, fewer than "<<options.min_on_time_senders<<"\n";
+        return;
+    }
+
+    /* One correction per sender; a querier's next message is already its query */
+    std::vector<uint8_t> correction;
+    std::vector<size_t> pending = on_time;
+    while (!pending.empty()) {
+        size_t from = network.receive_any_into(id, pending, correction);
+        pending.erase(std::find(pending.begin(), pending.end(), from));
+        if (correction.size() != aggregated_share.size()) {
+            throw std::runtime_error("close_round: correction of " + std::to_string(correction.size()) +
+                                     " bytes for a " + std::to_string(aggregated_share.size()) + "-byte aggregate");
+        }
+        xor_bytes(aggregated_share.bytes.data(), correction.data(), correction.size());
+    }
+    /* A late querier's share is queued ahead of its query; drop it */
+    for (size_t sender : late) {
+        if (sender <= options.queriers) {
+            network.recycle(network.receive(id, sender));
+        }
+    }
+    std::cout<<"ApproximateMpsiParty::close_round(): excluded "<<late.size()<<" late senders, applied "
+             <<on_time.size()<<" corrections\n";
+}
+
+void ApproximateMpsiParty::await_round_close(size_t id, size_t share_size) {
+    std::vector<uint8_t> message = network.receive(id, 0);
+    uint64_t status;
+    std::memcpy(&status, message.data(), sizeof(status));
+    std::vector<size_t> late(message.size() / sizeof(uint64_t) - 1);
+    for (size_t i = 0; i < late.size(); ++i) {
+        uint64_t sender;
+        std::memcpy(&sender, message.data() + (i + 1) * sizeof(uint64_t), sizeof(sender));
+        late[i] = sender;
+    }
+    aborted = status != 0;
+    if (aborted || std::find(late.begin(), late.end(), id) != late.end()) {
+        return;  // Our self-mask stays on the share: the round is void, or it was too late to count
+    }
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<uint8_t> correction = round_mask.to_bytes();
+    if (!late.empty()) {
+        SimdBytes zero_part = seeds.expand_pairs(late, zero_share_byte_count());
+        /* Legacy shares wrap the zero share around the filter (byte i uses zero byte i % size) */
+        for (size_t i = 0; i < share_size; ++i) {
+            correction[i] ^= zero_part.bytes[i % zero_part.size()];
+        }
+    }
+    auto end_time = std::chrono::steady_clock::now();
+    stats.log_duration(Stats::OPS::XOF_OP, id, start_time, end_time);
+    network.send(id, 0, correction);
+}
+
+/* Simulated slow client: with probability straggler_fraction it holds its share back */
+void ApproximateMpsiParty::straggle(size_t id) const {
+    if (id <= options.queriers || options.straggler_fraction <= 0.0 || options.straggler_delay_ms <= 0.0) {
+        return;
+    }
+    std::mt19937_64 rng(std::random_device{}());
+    if (std::bernoulli_distribution(options.straggler_fraction)(rng)) {
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(options.straggler_delay_ms));
+    }
+}
+
+/* One server shard: aggregates its slice of every client's share and answers each querier
+   with per-element partial XORs over the indices it owns */
+void ApproximateMpsiParty::run_shard(size_t shard, size_t n_parties) {
+    const size_t endpoint = ShardLayout::endpoint(shard, n_parties);
+    SimdBytes slice = aggregate_shares(endpoint, aggregation_children(0, n_parties));
+    std::cout<<"ApproximateMpsiParty::run_shard(): shard "<<shard<<" holds "<<slice.size()<<" bytes\n";
+
+    std::vector<size_t> pending;
+    for (size_t q = 1; q <= options.queriers; ++q) {
+        pending.push_back(q);
+    }
+    std::vector<uint8_t> message;
+    while (!pending.empty()) {
+        size_t from = network.receive_any_into(endpoint, pending, message);
+        pending.erase(std::find(pending.begin(), pending.end(), from));
+        std::vector<std::vector<size_t>> query_patterns = FullMesh::decode_index_patterns(message);
+        network.send(endpoint, from, compute_partial_xors(endpoint, query_patterns, slice.bytes.data(), slice.size()));
+    }
+    network.recycle(std::move(message));
+}
+
+std::vector<uint8_t> ApproximateMpsiParty::compute_partial_xors(size_t id, const std::vector<std::vector<size_t>>& query_patterns,
+                                                               const uint8_t* share, size_t share_size) {
+    const size_t width = probe_width();
+    std::vector<uint8_t> partials(query_patterns.size() * width, 0);
+    auto start_time = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < query_patterns.size(); ++q) {
+        uint8_t* partial = partials.data() + q * width;
+        for (size_t index : query_patterns[q]) {
+            assert((index + 1) * width <= share_size);
+            xor_bytes(partial, share + index * width, width);
+        }
+    }
+    auto end_time = std::chrono::steady_clock::now();
+    stats.log_duration(Stats::OPS::XOR_OP, id, start_time, end_time);
+    return partials;
+}
+
+void ApproximateMpsiParty::answer_queries(size_t id, const uint8_t* aggregated_share, size_t share_size) {
+    const size_t bin_total = share_size / probe_width();
+
+    /* Batches are evaluated concurrently as they arrive; each querier's results go back in
+       the order its batches were sent, so a task sends only after its predecessor has */
+    ThreadPool pool(std::max<size_t>(1, options.query_threads));
+    std::vector<size_t> remaining(options.queriers + 1, options.query_batches);
+    std::vector<std::shared_future<void>> last_sent(options.queriers + 1);
+    std::vector<size_t> pending;
+    while (true) {
+        pending.clear();
+        for (size_t q = 1; q <= options.queriers; ++q) {
+            if (remaining[q] > 0) pending.push_back(q);
+        }
+        if (pending.empty()) break;
+
+        std::vector<uint8_t> message;
+        size_t from = network.receive_any_into(id, pending, message);
+        remaining[from]--;
+        std::shared_future<void> previous = last_sent[from];
+        auto task = pool.enqueue([this, id, from, bin_total, previous, aggregated_share, share_size](std::vector<uint8_t> query) {
+            std::vector<std::vector<size_t>> query_patterns = decode_query(query, bin_total);
+            /* Each result chunk goes out as soon as it is evaluated; see result_chunk_count() */
+            const size_t chunk = options.result_chunk > 0 ? options.result_chunk : std::max<size_t>(1, query_patterns.size());
+            const size_t chunk_count = result_chunk_count(query_patterns.size());
+            for (size_t c = 0; c < chunk_count; ++c) {
+                std::vector<bool> results = compute_query_results(id, query_patterns, aggregated_share, share_size,
+                                                                  c * chunk, (c + 1) * chunk);
+                if (c == 0 && previous.valid()) previous.wait();
+                network.send(id, from, results);
+            }
+            std::cout<<"ApproximateMpsiParty::answer_queries(): querier "<<from<<", query pattern size="
+                     <<query_patterns.size()<<", result chunks="<<chunk_count<<"\n";
+        }, std::move(message));
+        last_sent[from] = task.share();
+    }
+    for (auto& sent : last_sent) {
+        if (sent.valid()) sent.get();
+    }
+}
+
+size_t ApproximateMpsiParty::result_chunk_count(size_t pattern_count) const {
+    /* An empty batch still gets one (empty) reply */
+    if (options.result_chunk == 0 || pattern_count == 0) return 1;
+    return (pattern_count + options.result_chunk - 1) / options.result_chunk;
+}
+
+Set ApproximateMpsiParty::query_server(size_t id, const Set& input, size_t server_id, const MatchCallback& on_match) {
+    // Send the query in batches; all are in flight before the first result is read
+    std::vector<size_t> batch_sizes;
+    std::vector<std::vector<uint8_t>> batches = encode_query_batches(input, options.query_batches, batch_sizes);
+    size_t sent_bytes = 0;
+    for (const auto& batch : batches) {
+        /* channels.send(0, query_patterns); */
+        sent_bytes += batch.size();
+        network.send(id, server_id, batch);
+    }
+    std::cout<<"ApproximateMpsiParty::query_server():input size = "<<input.to_vector().size()<<", batches="<<batches.size()
+             <<", "<<options.query_encoding<<" query bytes="<<sent_bytes<<"\n";
+
+    // Receive the response chunk by chunk and emit matches as they arrive. Results follow
+    // input.ordered_elements(); each chunk is packed result bits, padded to whole bytes
+    const std::vector<size_t>& elements = input.ordered_elements();
+    size_t cursor = 0;
+    std::vector<size_t> matches;
+    for (size_t b = 0; b < batches.size(); ++b) {
+        size_t remaining = batch_sizes[b];
+        const size_t chunk_count = result_chunk_count(batch_sizes[b]);
+        for (size_t c = 0; c < chunk_count; ++c) {
+            /* channels.receive(0, results); */
+            std::vector<uint8_t> chunk_bits = network.receive(id, server_id);
+            const size_t count = std::min(remaining, options.result_chunk > 0 ? options.result_chunk : remaining);
+            if (chunk_bits.size() * 8 < count) {
+                throw std::runtime_error("query_server: result chunk of " + std::to_string(chunk_bits.size()) +
+                                         " bytes for " + std::to_string(count) + " patterns");
+            }
+            size_t found = extract_intersection(elements.data() + cursor, count, chunk_bits.data(), matches);
+            if (on_match) {
+                for (size_t m = matches.size() - found; m < matches.size(); ++m) on_match(matches[m]);
+            }
+            cursor += count;
+            remaining -= count;
+        }
+    }
+    /* The one hashing pass left: the caller-facing Set */
+    Set output(std::unordered_set<size_t>(matches.begin(), matches.end()));
+    if (input.has_byte_strings()) {
+        output.share_byte_strings(input);
+        auto matched = output.to_vector();
+        if (!matched.empty()) {
+            std::cout<<"ApproximateMpsiParty::query_server():first matched key = "<<output.byte_string(matched[0]).value_or("?")<<"\n";
+        }
+    }
+    std::cout<<"ApproximateMpsiParty::query_server():ouput size (extracted intersection size) = "<<output.to_vector().size()<<"\n";
+    return output;
+}
+
+/* Sharded query: each index goes to the shard owning its bin (rebased to the shard's
+   slice); an element matches when the XOR of all shards' partials is zero */
+Set ApproximateMpsiParty::query_shards(size_t id, const Set& input) {
+    std::vector<std::vector<size_t>> query_patterns = generate_query_patterns(input);
+    ShardLayout layout(options.server_shards, share_units, probe_width());
+
+    std::vector<std::vector<std::vector<size_t>>> shard_patterns(layout.shard_count(),
+                                                                 std::vector<std::vector<size_t>>(query_patterns.size()));
+    for (size_t q = 0; q < query_patterns.size(); ++q) {
+        for (size_t index : query_patterns[q]) {
+            size_t shard = layout.owner(index);
+            shard_patterns[shard][q].push_back(index - layout.first_unit(shard));
+        }
+    }
+    for (size_t shard = 0; shard < layout.shard_count(); ++shard) {
+        network.send(id, ShardLayout::endpoint(shard, options.party_count), shard_patterns[shard]);
+    }
+
+    const size_t width = probe_width();
+    std::vector<uint8_t> combined(query_patterns.size() * width, 0);
+    for (size_t shard = 0; shard < layout.shard_count(); ++shard) {
+        std::vector<uint8_t> partials = network.receive(id, ShardLayout::endpoint(shard, options.party_count));
+        if (partials.size() != combined.size()) {
+            throw std::runtime_error("query_shards: shard " + std::to_string(shard) + " answered " +
+                                     std::to_string(partials.size()) + " bytes, expected " + std::to_string(combined.size()));
+        }
+        xor_bytes(combined.data(), partials.data(), combined.size());
+    }
+
+    std::vector<uint8_t> result_bits((query_patterns.size() + 7) / 8, 0);
+    for (size_t q = 0; q < query_patterns.size(); ++q) {
+        const uint8_t* bytes = combined.data() + q * width;
+        if (std::all_of(bytes, bytes + width, [](uint8_t b) { return b == 0; })) {
+            result_bits[q / 8] |= static_cast<uint8_t>(1 << (q % 8));
+        }
+    }
+    std::vector<size_t> matches;
+    extract_intersection(input.ordered_elements().data(), query_patterns.size(), result_bits.data(), matches);
+    Set output(std::unordered_set<size_t>(matches.begin(), matches.end()));
+    std::cout<<"ApproximateMpsiParty::query_shards(): "<<layout.shard_count()<<" shards, ouput size (extracted intersection size) = "
+             <<output.to_vector().size()<<"\n";
+    return output;
+}
+
 Set ApproximateMpsiParty::run_querier_approx(size_t id, const Set& input, Channels& channels) {
     auto start_time = std::chrono::steady_clock::now();
 
     // Act as a client first
     run_client_approx(id, input, channels);
+    if (aborted) {
+        return Set();  // The server answers no queries in an aborted round
+    }
 
-    // Send query patterns
-    std::vector<std::vector<size_t>> query_patterns = generate_query_patterns(input);
-    std::cout<<"ApproximateMpsiParty::run_querier_approx():input size = "<<input.to_vector().size()<<", query_patterns size="<<query_patterns.size()<<"\n";
-    /* channels.send(0, query_patterns); */
-    network.send(id, 0, query_patterns);
-    
-    // Receive response from server 
-    std::vector<bool> results;
-    /* channels.receive(0, results); */
-    network.receive(id, 0, results);
+    /* Time to first result: the first match the server's result stream delivers */
+    std::optional<std::chrono::steady_clock::time_point> first_match;
+    auto on_match = [&first_match](size_t) {
+        if (!first_match) first_match = std::chrono::steady_clock::now();
+    };
+    Set output = options.server_shards > 1 ? query_shards(id, input) : query_server(id, input, 0, on_match);
+    if (first_match) {
+        std::cout<<"ApproximateMpsiParty::run_querier_approx(): first match after "
+                 <<std::chrono::duration_cast<std::chrono::microseconds>(*first_match - start_time).count() / 1000.0<<" ms\n";
+    }
 
-    // Extract intersection
-    Set output = extract_intersection(input, results);
-    std::cout<<"ApproximateMpsiParty::run_querier_approx():ouput size (extracted intersection size) = "<<output.to_vector().size()<<"\n";
     // Log execution time
     auto end_time = std::chrono::steady_clock::now();
     //stats.log_duration("Querier Execution Time", start_time, end_time);
@@ -404,51 +1117,282 @@ Set ApproximateMpsiParty::run_querier_approx(size_t id, const Set& input, Channe
 }
 
 void ApproximateMpsiParty::run_client_approx(size_t id, const Set& input, Channels& channels) {
-    
+    if (options.encoding == "fuse") {
+        run_client_fuse(id, input);
+        return;
+    }
+
 
     // Encode input into a Bloom filter
     std::vector<bool> bloom_filter;
     //Running as lambda function for bloom filter
-    std::thread bloom_thread([&bloom_filter, /*&bloom_done,*/ &input, this, id]() {
+    std::future<void> bloom_task = compute_pool().enqueue([&bloom_filter, /*&bloom_done,*/ &input, this, id]() {
         auto start_time = std::chrono::steady_clock::now();
         bloom_filter = input.to_bloom_filter(this->bin_count, this->hash_count, this->hash_func);//Xi
         std::cout<<"ApproximateMpsiParty::run_client_approx(): bloom filter size="<<bloom_filter.size()<<"\n";
         auto end_time = std::chrono::steady_clock::now();
-        g_stats.log_duration(Stats::OPS::BLOOMFILTER_OP, id, start_time, end_time);
+        stats.log_duration(Stats::OPS::BLOOMFILTER_OP, id, start_time, end_time);
    });
 
     auto start_time = std::chrono::steady_clock::now();
+    if (options.share_width > 0) {
+        /* Bin-aligned shares: share_width bytes per bin, one bin per filter bit */
+        ZeroShare share = acquire_zero_share(id, zero_share_byte_count());
+        bloom_task.get();
+        SimdBytes corrupted_share;
+        if (options.stream_chunk_bins > 0) {
+            corrupted_share = stream_corrupted_share(id, share, bloom_filter, options.share_width, start_time);
+        } else {
+            corrupted_share = conditionally_corrupt_share_chunked_parallel(share.data(), share.size(), bloom_filter, options.share_width);
+            auto end_time = std::chrono::steady_clock::now();
+            stats.log_duration(Stats::OPS::XOF_OP, id, start_time, end_time);
+            send_share(id, corrupted_share.bytes.data(), corrupted_share.size());
+        }
+        std::cout<<"ApproximateMpsiParty::run_client_approx(): share width="<<options.share_width
+                 <<", corrupted share size="<<corrupted_share.size()<<"\n";
+        if (options.delta_churn > 0 && id >= 2) {
+            run_client_delta_update(id, input, bloom_filter, options.share_width, share.to_simd_bytes(), corrupted_share);
+        }
+        return;
+    }
+
     // Generate a zero share and corrupt it conditionally
     //SimdBytes share = create_zero_share(seeds, SHARE_BYTE_COUNT * bin_count, hash_func);//Mi
-    SimdBytes share = create_zero_share_no_resize(seeds, SHARE_BYTE_COUNT * bin_count, hash_func);//Mi //g_options.set_size
+    ZeroShare share = acquire_zero_share(id, zero_share_byte_count());//Mi //options.set_size
     //SimdBytes share = create_zero_share_parallel(seeds, SHARE_BYTE_COUNT * bin_count, hash_func);//Mi
-    //SimdBytes share = create_zero_share_parallel(seeds, g_options.set_size, hash_func);
+    //SimdBytes share = create_zero_share_parallel(seeds, options.set_size, hash_func);
     std::cout << "Bloom Filter Size: " << bloom_filter.size()
           << ", bin_count: " << bin_count
           << ", Seeds size: " << seeds.size()
-          << ", Expected false_values.bytes.size(): " << share.to_bytes().size()
+          << ", Expected false_values.bytes.size(): " << share.size()
           << std::endl;
     // Wait for bloom filter to be ready
-    bloom_thread.join();
+    bloom_task.get();
+
+    if (options.stream_chunk_bins > 0) {
+        SimdBytes corrupted_share = stream_corrupted_share(id, share, bloom_filter, 1, start_time);
+        if (options.delta_churn > 0 && id >= 2) {
+            run_client_delta_update(id, input, bloom_filter, 1, share.to_simd_bytes(), corrupted_share);
+        }
+        return;
+    }
 
     //SimdBytes corrupted_share = conditionally_corrupt_share(share, bloom_filter);//Ri
-    SimdBytes corrupted_share = conditionally_corrupt_share_parallel(share, bloom_filter);
-    std::cout<<"ApproximateMpsiParty::run_client_approx(): share size="<<share.to_bytes().size()<<", corrupted share size="<<corrupted_share.to_bytes().size()<<"\n";
+    SimdBytes corrupted_share = conditionally_corrupt_share_parallel(share.data(), share.size(), bloom_filter);
+    std::cout<<"ApproximateMpsiParty::run_client_approx(): share size="<<share.size()<<", corrupted share size="<<corrupted_share.to_bytes().size()<<"\n";
     // Log execution time
     auto end_time = std::chrono::steady_clock::now();
-    g_stats.log_duration(Stats::OPS::XOF_OP, id, start_time, end_time);
+    stats.log_duration(Stats::OPS::XOF_OP, id, start_time, end_time);
 
     // Send the share to the server
     /* channels.send(corrupted_share.to_bytes(), 0); */
-    network.send(id, 0, corrupted_share.to_bytes());
+    send_share(id, corrupted_share.bytes.data(), corrupted_share.size());
+
+    if (options.delta_churn > 0 && id >= 2) {
+        run_client_delta_update(id, input, bloom_filter, 1, share.to_simd_bytes(), corrupted_share);
+    }
 
     //stats.log_duration("Client Execution Time", start_time, end_time);
     std::cout<<"ApproximateMpsiParty::run_client_approx():"<<start_time.time_since_epoch().count()<<", "<<end_time.time_since_epoch().count()<<"\n";
 }
 
+/* Fuse encoding: the share is the zero share XOR the encoded filter cells. A common element
+   then XORs to its fingerprint once per sender, so the querier encodes fingerprints only when
+   the other senders are odd in number and the server's test stays "all zero" */
+void ApproximateMpsiParty::run_client_fuse(size_t id, const Set& input) {
+    BinaryFuseFilter filter(options.set_size, options.fuse_fingerprint_bytes, RANDOM_SEED);
+    bool with_fingerprints = fuse_encodes_fingerprints(id, options.party_count);
+
+    std::vector<uint8_t> cells(filter.byte_size());
+    std::future<void> fuse_task = compute_pool().enqueue([&cells, &filter, &input, with_fingerprints, this, id]() {
+        auto start_time = std::chrono::steady_clock::now();
+        filter.encode(input.element_digests(this->hash_func), cells.data(), with_fingerprints);
+        auto end_time = std::chrono::steady_clock::now();
+        stats.log_duration(Stats::OPS::BLOOMFILTER_OP, id, start_time, end_time);
+    });
+
+    auto start_time = std::chrono::steady_clock::now();
+    ZeroShare zero_share = acquire_zero_share(id, filter.byte_size());
+    fuse_task.get();
+    const uint8_t* zero = zero_share.data();
+    const size_t width = filter.fingerprint_bytes();
+    auto mask_cells = [&cells, zero, width](size_t first_cell, size_t cell_count) {
+        for (size_t i = first_cell * width; i < (first_cell + cell_count) * width; ++i) {
+            cells[i] ^= zero[i];
+        }
+    };
+
+    std::cout<<"ApproximateMpsiParty::run_client_fuse(): cells="<<filter.cell_count()
+             <<", fingerprint bytes="<<width<<", share size="<<cells.size()
+             <<", bits/element="<<(8.0 * filter.byte_size()) / std::max<size_t>(1, input.to_vector().size())<<"\n";
+    if (options.stream_chunk_bins > 0) {
+        stream_share(id, cells.data(), filter.cell_count(), width, mask_cells, start_time);
+        return;
+    }
+    mask_cells(0, filter.cell_count());
+    auto end_time = std::chrono::steady_clock::now();
+    stats.log_duration(Stats::OPS::XOF_OP, id, start_time, end_time);
+    send_share(id, cells.data(), cells.size());
+}
+
+/* Whole-share upload: to the server, or with --server-shards each shard gets its slice */
+void ApproximateMpsiParty::send_share(size_t id, const uint8_t* share, size_t size) {
+    share_units = size / probe_width();
+    straggle(id);
+    if (options.aggregation_fan_in > 0) {
+        /* Intermediate aggregator: fold the subtree's shares into ours, forward one share */
+        SimdBytes combined = aggregate_shares(id, aggregation_children(id, options.party_count));
+        if (combined.size() == 0) {
+            combined = SimdBytes::from_bytes(std::vector<uint8_t>(share, share + size));
+        } else {
+            if (combined.size() != size) {
+                throw std::runtime_error("send_share: subtree of party " + std::to_string(id) + " sent " +
+                                         std::to_string(combined.size()) + "-byte shares, expected " + std::to_string(size));
+            }
+            xor_bytes(combined.bytes.data(), share, size);
+        }
+        network.send(id, aggregation_parent(id), combined.to_bytes());
+        return;
+    }
+    if (options.server_shards <= 1 && options.round_deadline_ms > 0) {
+        /* Fresh self-mask, returned only once the server lists this sender as on time */
+        const SeedKey key = CorrelatedSeeds::random_key();
+        round_mask = SimdBytes(size, 0);
+        blake3_hasher hasher;
+        blake3_hasher_init_keyed(&hasher, key.data());
+        blake3_hasher_finalize(&hasher, round_mask.bytes.data(), size);
+        std::vector<uint8_t> masked(share, share + size);
+        xor_bytes(masked.data(), round_mask.bytes.data(), size);
+        network.send(id, 0, masked);
+        await_round_close(id, size);
+        return;
+    }
+    if (options.server_shards <= 1) {
+        network.send(id, 0, std::vector<uint8_t>(share, share + size));
+        return;
+    }
+    ShardLayout layout(options.server_shards, share_units, probe_width());
+    for (size_t shard = 0; shard < layout.shard_count(); ++shard) {
+        network.send(id, ShardLayout::endpoint(shard, options.party_count),
+                     std::vector<uint8_t>(share + layout.byte_begin(shard), share + layout.byte_end(shard)));
+    }
+}
+
+/* Streamed upload: bins are produced stream_chunk_bins at a time and handed to a sender
+   thread, so masking the next range overlaps the (simulated) transfer of the previous one */
+void ApproximateMpsiParty::stream_share(size_t id, uint8_t* share, size_t bin_total, size_t width,
+                                        const std::function<void(size_t, size_t)>& produce,
+                                        std::chrono::steady_clock::time_point start_time) {
+    straggle(id);
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::queue<std::pair<size_t, std::vector<uint8_t>>> pending;  // (recipient, chunk)
+    bool done = false;
+
+    std::thread sender([&, id]() {
+        std::unordered_set<size_t> started;
+        while (true) {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cv.wait(lock, [&]() { return !pending.empty() || done; });
+            if (pending.empty()) break;
+            auto [recipient, message] = std::move(pending.front());
+            pending.pop();
+            lock.unlock();
+            network.send_stream_chunk(id, recipient, message, started.insert(recipient).second);
+        }
+    });
+
+    /* With shards, a chunk is cut at shard boundaries and offsets become slice-relative */
+    const size_t total = bin_total * width;
+    share_units = total / probe_width();
+    ShardLayout layout(std::max<size_t>(1, options.server_shards), share_units, probe_width());
+    auto slice_begin = [&](size_t shard) { return layout.shard_count() == 1 ? 0 : layout.byte_begin(shard); };
+    auto slice_end = [&](size_t shard) { return layout.shard_count() == 1 ? total : layout.byte_end(shard); };
+    auto stream_begin = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration compute_time{0};
+    size_t chunk_count = 0;
+    for (size_t first_bin = 0; first_bin < bin_total; first_bin += options.stream_chunk_bins) {
+        size_t bins = std::min(options.stream_chunk_bins, bin_total - first_bin);
+        auto chunk_start = std::chrono::steady_clock::now();
+        produce(first_bin, bins);
+        std::vector<std::pair<size_t, std::vector<uint8_t>>> messages;
+        const size_t begin = first_bin * width, end = (first_bin + bins) * width;
+        for (size_t shard = 0; shard < layout.shard_count(); ++shard) {
+            size_t lo = std::max(begin, slice_begin(shard));
+            size_t hi = std::min(end, slice_end(shard));
+            if (lo < hi) {
+                messages.emplace_back(ShardLayout::endpoint(shard, options.party_count),
+                                      encode_share_chunk(lo - slice_begin(shard), slice_end(shard) - slice_begin(shard),
+                                                         share + lo, hi - lo));
+            }
+        }
+        compute_time += std::chrono::steady_clock::now() - chunk_start;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            for (auto& message : messages) {
+                pending.push(std::move(message));
+            }
+        }
+        queue_cv.notify_one();
+        chunk_count++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        done = true;
+    }
+    queue_cv.notify_one();
+    sender.join();
+
+    /* Client compute is the work before streaming plus the masking; the upload overlapped it */
+    stats.log_duration(Stats::OPS::XOF_OP, id, start_time, stream_begin + compute_time);
+    std::cout<<"ApproximateMpsiParty::stream_share(): "<<chunk_count<<" chunks of up to "
+             <<options.stream_chunk_bins * width<<" bytes, "<<total<<" bytes total\n";
+}
+
+SimdBytes ApproximateMpsiParty::stream_corrupted_share(size_t id, const ZeroShare& share, const std::vector<bool>& bloom_filter,
+                                                       size_t width, std::chrono::steady_clock::time_point start_time) {
+    SimdBytes corrupted_share(bloom_filter.size() * width);
+    std::random_device rd;
+    stream_share(id, corrupted_share.bytes.data(), bloom_filter.size(), width,
+                 [&](size_t first_bin, size_t bins) {
+                     corrupt_share_range(share.data(), share.size(), bloom_filter, first_bin, bins, width,
+                                         corrupted_share.bytes.data() + first_bin * width, rd);
+                 }, start_time);
+    return corrupted_share;
+}
+
+/* Next session: swap delta_churn elements for fresh ones and send only the changed bins */
+void ApproximateMpsiParty::run_client_delta_update(size_t id, const Set& input, const std::vector<bool>& bloom_filter, size_t width,
+                                                   const SimdBytes& zero_share, const SimdBytes& sent_share) {
+    DeltaShareClient delta_client(input, bloom_filter, width, hash_count, hash_func, zero_share, sent_share);
+
+    std::vector<size_t> current = input.to_vector();
+    std::vector<size_t> removed(current.begin(), current.begin() + std::min(options.delta_churn, current.size()));
+    std::vector<size_t> added;
+    std::mt19937_64 rng(std::random_device{}());
+    while (added.size() < removed.size()) {
+        size_t element = rng() % options.domain_size;
+        if (!input.contains(element) && std::find(added.begin(), added.end(), element) == added.end()) {
+            added.push_back(element);
+        }
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    ShareDelta delta = delta_client.update(added, removed);
+    std::vector<uint8_t> message = delta.serialize();
+    auto end_time = std::chrono::steady_clock::now();
+    stats.log_duration(Stats::OPS::XOF_OP, id, start_time, end_time);
+
+    std::cout<<"ApproximateMpsiParty::run_client_delta_update(): delta bins="<<delta.bins.size()
+             <<", delta bytes="<<message.size()<<", full share bytes="<<sent_share.size()<<"\n";
+    network.send(id, 0, message);
+    updated_input = delta_client.elements();
+}
+
 std::optional<Set> ApproximateMpsiParty::run(size_t id, size_t n_parties, const Input& input, Channels& channels, thread_data* t_data) {
     Set output;
     auto start_time = std::chrono::steady_clock::now();
+    network.mark_active(id);
     switch(id) {
         case 0:
             run_server_approx(id, n_parties, channels);
@@ -459,15 +1403,23 @@ std::optional<Set> ApproximateMpsiParty::run(size_t id, size_t n_parties, const
             break;
 
         default:
+            if (id <= options.queriers) {
+                /* Additional authorized querier: contributes a share and queries like party 1 */
+                output = run_querier_approx(id, *input, channels);
+                break;
+            }
             run_client_approx(id, *input, channels);
+            if (updated_input) {
+                output = *updated_input;
+            }
             break;
         
     }
     auto end_time = std::chrono::steady_clock::now();
-    g_stats.log_duration(Stats::OPS::COMPUTE_BREAKDOWN, id, start_time, end_time);
+    stats.log_duration(Stats::OPS::COMPUTE_BREAKDOWN, id, start_time, end_time);
     t_data->id = id;
-    t_data->output = output;
-    t_data->is_completed = true;
+    t_data->finished = end_time;
+    t_data->result.set_value(output);
     return output;
 }
 
@@ -11,6 +11,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <mutex>
+#include <future>
 #include <cstdint>
 #include "FullMesh.hpp"
 #include "Stats.hpp"
@@ -18,14 +19,29 @@
 #include "secret_sharing_simd.hpp"
 #include "Set.hpp"
 #include "hash_funcs.hpp"
+#include "delta_share.hpp"
+#include "BinaryFuseFilter.hpp"
+#include "ZeroShareStore.hpp"
+#include "share_stream.hpp"
+#include "query_encoding.hpp"
+#include "ShareEpochServer.hpp"
+#include "CorrelatedSeeds.hpp"
+#include "TaskRuntime.hpp"
+#include <functional>
+#include <chrono>
 
 // Constants
 //constexpr size_t SHARE_BYTE_COUNT = 5;
+constexpr size_t SEEDS_PER_ELEMENT = 40; /* Zero-share seeds per set element (setup_parties2) */
+const std::string FINGERPRINT_KEY_CONTEXT = "Outsourced-MPSI 2025 byte-string element fingerprints";
+
+// Called by the querier for each intersection element as its result chunk arrives
+using MatchCallback = std::function<void(size_t element)>;
 
 typedef struct thread_data {
     size_t id;
-    bool is_completed;
-    std::optional<Set> output;
+    std::promise<std::optional<Set>> result;        /* Fulfilled when run() returns */
+    std::chrono::steady_clock::time_point finished; /* Written before 'result' is set */
 };
 
 class Party {
@@ -39,7 +55,9 @@ public:
 class ApproximateMpsi {
 public:
     // Constructor
-    ApproximateMpsi(FullMesh& net, size_t bin_count, size_t hash_count, std::string hash_func, size_t domain_size, size_t set_size /*, Stats& stats*/);
+    // 'options' and 'stats' belong to this instance's session; they default to the process-wide ones
+    ApproximateMpsi(FullMesh& net, size_t bin_count, size_t hash_count, std::string hash_func, size_t domain_size, size_t set_size,
+                    const Options& options = g_options, Stats& stats = g_stats);
 
     std::vector<Set> gen_sets_with_uniform_intersection(size_t n_parties, size_t set_size, size_t domain_size);
     std::vector<std::optional<Set>> generate_inputs(size_t n_parties) /*const*/;
@@ -47,38 +65,96 @@ public:
                             const std::vector<std::optional<Set>>& outputs) /*const*/;
     // Main evaluation function
     /*Stats*/ 
-    void evaluate(const std::string& experiment_name, size_t party_count,
+    // Returns the number of repetitions whose outputs validated
+    size_t evaluate(const std::string& experiment_name, size_t party_count,
                                 const FullMesh& network_description, size_t repetitions);
     std::vector<std::unique_ptr<Party>> setup_parties(size_t n_parties);
-    std::vector<std::unique_ptr<Party>> setup_parties2(size_t n_parties, size_t seeds_sz_factor);
+    std::vector<std::unique_ptr<Party>> setup_parties2(size_t n_parties, size_t seeds_sz_factor, size_t session_id = 0);
+
+    // Offline phase: write every sender's zero share for the next 'repetitions' sessions
+    void precompute_zero_shares(size_t party_count, size_t repetitions);
+
+    // Repetitions first, first + stride, ... on this instance's network (one lane of evaluate())
+    size_t run_repetitions(size_t party_count, size_t first, size_t stride, size_t repetitions);
+
+    // Long-running server: ingest 'epochs' rounds of client shares, continuing after a
+    // restored snapshot's epoch. Each epoch's queriers are answered from the live aggregate
+    // while that epoch ingests; clients keep their sets, so any epoch answers them
+    void run_daemon(size_t party_count, size_t epochs);
+
+    // Run send-only parties on workers shared with other sessions instead of a private pool
+    void use_party_scheduler(FairScheduler& scheduler, size_t tenant);
 
 private:
+    // Online phase: throws unless every sender's offline zero share for the session is there
+    void require_zero_shares(const std::vector<std::unique_ptr<Party>>& parties, size_t party_count, size_t session_id) const;
+
     size_t bin_count;
     size_t hash_count;
     std::string hash_func;
     size_t domain_size;
     size_t set_size;
-    //Stats& stats;
+    const Options& options;
+    Stats& stats;
     FullMesh& network;
+    FairScheduler* party_scheduler = nullptr;
+    size_t tenant = 0;
 };
 
 // ApproximateMpsiParty class: Represents a single party in the protocol
 class ApproximateMpsiParty : public Party {
 public:
     // Constructor
-    ApproximateMpsiParty(FullMesh& net, std::vector<std::array<uint8_t, RAND_SECRET_SIZE>> seeds, size_t bin_count, size_t hash_count, std::string hash_func /*, Stats& stats*/);
+    ApproximateMpsiParty(FullMesh& net, CorrelatedSeeds seeds, size_t bin_count, size_t hash_count, std::string hash_func, size_t session_id = 0,
+                         const Options& options = g_options, Stats& stats = g_stats);
 
     // Public interface
     //std::optional<Set> run(size_t id, size_t n_parties, const std::optional<Set>& input, 
     //                       Channels& channels);
     std::optional<Set> run(size_t id, size_t n_parties, const Input& input, Channels& channels, thread_data* th_data);
+
+    // Offline phase: compute this party's zero share and store it for the session
+    void precompute_zero_share(size_t id);
+    // Online phase: whether the offline run left this party's zero share for the session
+    bool has_precomputed_zero_share(size_t id) const;
+
+    // Reuse this party for another session of the same inputs
+    void begin_session(size_t session_id, CorrelatedSeeds seeds);
+
+    // Server: senders left out of the last round for missing its deadline
+    const std::vector<size_t>& excluded_senders() const;
+    // Whether the last round was aborted for having too few senders on time
+    bool round_aborted() const;
+
+    // Protocol steps the daemon drives separately (run() chains them for one session)
+    void run_client_approx(size_t id, const Set& input, Channels& channels);
+    // With 'late', gives up at 'deadline' and lists the senders whose share had not arrived
+    SimdBytes aggregate_shares(size_t id, const std::vector<size_t>& senders,
+                               std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(),
+                               std::vector<size_t>* late = nullptr);
+    size_t aggregation_parent(size_t id) const;
+    std::vector<size_t> aggregation_children(size_t id, size_t n_parties) const;
+    // Whether party 'id' waits on messages (server, queriers, aggregation tree nodes)
+    bool receives(size_t id, size_t n_parties) const;
+    void answer_queries(size_t id, const uint8_t* aggregated_share, size_t share_size);
+    Set query_server(size_t id, const Set& input, size_t server_id, const MatchCallback& on_match = nullptr);
+    void run_shard(size_t shard, size_t n_parties);
+    // Share bytes behind one query index under 'options'
+    static size_t probe_width(const Options& options);
 private:
-    std::vector<std::array<uint8_t, RAND_SECRET_SIZE>> seeds;
+    CorrelatedSeeds seeds;
     size_t bin_count;
     size_t hash_count;
     std::string hash_func;
-    //Stats& stats;
+    Stats& stats;
+    const Options& options;
     FullMesh& network;
+    std::optional<Set> updated_input; /* Client set after an incremental update */
+    size_t session_id;                /* Names the precomputed zero share of this session */
+    size_t share_units = 0;           /* Probe units (bins) in the share this party sent */
+    std::vector<size_t> excluded;     /* Server: late senders of the last round */
+    bool aborted = false;             /* Last round had fewer than min_on_time_senders on time */
+    SimdBytes round_mask;             /* Sender: self-mask on its share for a round with a deadline */
 
     // Internal functions
     /*void run_server_approx(size_t n_parties, Channels& channels);
@@ -86,14 +162,36 @@ private:
     void run_client_approx(const Set& input, Channels& channels);
    */
     std::vector<bool> compute_query_results(size_t id, const std::vector<std::vector<size_t>>& query_patterns, 
-    const SimdBytes& aggregated_share);
+    const uint8_t* aggregated_share, size_t share_size, size_t begin = 0, size_t end = SIZE_MAX);
+    size_t result_chunk_count(size_t pattern_count) const;
+    size_t probe_width() const;
     std::vector<std::vector<size_t>> generate_query_patterns(const Set& input);
-    Set extract_intersection(const Set& input, const std::vector<bool>& results);
+    std::vector<std::vector<uint8_t>> encode_query_batches(const Set& input, size_t batch_count, std::vector<size_t>& batch_sizes);
+    std::vector<std::vector<size_t>> decode_query(const std::vector<uint8_t>& message, size_t bin_total) const;
+    // Append elements[i] for every set bit i < count of the packed results; returns the number appended
+    static size_t extract_intersection(const size_t* elements, size_t count, const uint8_t* result_bits,
+                                       std::vector<size_t>& matches);
+    std::vector<uint8_t> compute_partial_xors(size_t id, const std::vector<std::vector<size_t>>& query_patterns,
+                                              const uint8_t* share, size_t share_size);
+    Set query_shards(size_t id, const Set& input);
+    void send_share(size_t id, const uint8_t* share, size_t size);
+    void close_round(size_t id, size_t n_parties, const std::vector<size_t>& late, SimdBytes& aggregated_share);
+    void await_round_close(size_t id, size_t share_size);
+    void straggle(size_t id) const;
     //std::vector<size_t> bloom_filter_indices(const size_t element, size_t bin_count, size_t hash_count);
 
     void run_server_approx(size_t id, size_t n_parties, Channels& channels);
     Set run_querier_approx(size_t id, const Set& input, Channels& channels);
-    void run_client_approx(size_t id, const Set& input, Channels& channels);
+    void run_client_fuse(size_t id, const Set& input);
+    size_t zero_share_byte_count() const;
+    void stream_share(size_t id, uint8_t* share, size_t bin_total, size_t width,
+                      const std::function<void(size_t, size_t)>& produce,
+                      std::chrono::steady_clock::time_point start_time);
+    SimdBytes stream_corrupted_share(size_t id, const ZeroShare& share, const std::vector<bool>& bloom_filter,
+                                     size_t width, std::chrono::steady_clock::time_point start_time);
+    ZeroShare acquire_zero_share(size_t id, size_t byte_count);
+    void run_client_delta_update(size_t id, const Set& input, const std::vector<bool>& bloom_filter, size_t width,
+                                 const SimdBytes& zero_share, const SimdBytes& sent_share);
 };
 
 #endif // APPROXIMATE_MPSI_HPP
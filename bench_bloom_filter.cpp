@@ -0,0 +1,77 @@
+// Bloom filter encoding benchmark: in-house Set::to_bloom_filter (standard and blocked
+// layouts) against the batch API of the bundled library filter (batch_bloom_filter).
+// Build with build_bench.sh; usage: ./bench_bloom_filter [set_size] [hash_count]
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include "Set.hpp"
+#include "common.hpp"
+#include "bloom_filter.hpp"
+#include "secret_sharing_simd.hpp"
+
+Options &g_options = *(new Options());
+
+template <typename F>
+static double time_ms(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t set_size = argc > 1 ? std::stoul(argv[1]) : 100000;
+    size_t hash_count = argc > 2 ? std::stoul(argv[2]) : 7;
+
+    g_options.hash_count = hash_count;
+    g_options.bloom_block_bins = DEFAULT_BLOOM_BLOCK_BINS;
+    g_options.share_width = 1;  // Filter size = bin count, same for every encoding
+    g_options.bin_count = set_size * 20;
+    g_options.bin_count -= g_options.bin_count % (SHARE_BYTE_COUNT * DEFAULT_BLOOM_BLOCK_BINS);
+
+    std::mt19937_64 rng(42);
+    std::unordered_set<size_t> elements;
+    while (elements.size() < set_size) elements.insert(rng());
+    std::vector<std::uint64_t> keys(elements.begin(), elements.end());
+    std::vector<std::uint64_t> probes(set_size);
+    for (auto& p : probes) p = rng();
+    Set set(elements);
+
+    std::cout << "set size = " << set_size << ", hash count = " << hash_count
+              << ", bins = " << g_options.bin_count << "\n";
+
+    for (const std::string layout : {"standard", "blocked"}) {
+        g_options.bloom_layout = layout;
+        double build = time_ms([&] { set.to_bloom_filter(g_options.bin_count, hash_count, "blake3_xof"); });
+        double query = time_ms([&] { set.bloom_filter_indices(g_options.bin_count, hash_count, "blake3_xof"); });
+        std::cout << "to_bloom_filter (" << layout << "): build " << build << " ms, query indices " << query << " ms\n";
+    }
+
+    bloom_parameters parameters;
+    parameters.projected_element_count = set_size;
+    parameters.random_seed = RANDOM_SEED;
+    parameters.optimal_parameters.number_of_hashes = static_cast<unsigned int>(hash_count);
+    parameters.optimal_parameters.table_size = g_options.bin_count;
+
+    bloom_filter scalar(parameters);
+    double scalar_build = time_ms([&] { for (auto key : keys) scalar.insert(key); });
+    size_t scalar_hits = 0;
+    double scalar_query = time_ms([&] { for (auto key : probes) scalar_hits += scalar.contains(key); });
+    std::cout << "bloom_filter (per key): build " << scalar_build << " ms, contains " << scalar_query
+              << " ms, false positives " << scalar_hits << "\n";
+
+    batch_bloom_filter batch(parameters);
+    std::vector<unsigned char> results(set_size);
+    double batch_build = time_ms([&] { batch.insert_many(keys.data(), keys.size()); });
+    double batch_query = time_ms([&] { batch.contains_many(probes.data(), probes.size(), results.data()); });
+    size_t batch_hits = 0;
+    for (auto r : results) batch_hits += r;
+    batch.contains_many(keys.data(), keys.size(), results.data());
+    size_t misses = 0;
+    for (auto r : results) misses += (r == 0);
+    std::cout << "batch_bloom_filter: build " << batch_build << " ms, contains_many " << batch_query
+              << " ms, false positives " << batch_hits << ", false negatives " << misses << "\n";
+
+    return misses == 0 ? 0 : 1;
+}
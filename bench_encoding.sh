@@ -0,0 +1,16 @@
+#!/bin/sh
+# End-to-end comparison of the bloom and binary fuse encodings at matching false-positive rates.
+# Usage: sh bench_encoding.sh [party_count] [repetitions]; results go to bench_<encoding>_<k>.csv
+PARTIES=${1:-4}
+REPS=${2:-3}
+for K in 1000 10000 100000; do
+    U=$((K * 100))
+    # Bloom: 14 bits/element, 10 hashes (~1e-3); fuse: 1-byte fingerprints (~4e-3) and 2 bytes (~1.5e-5)
+    ./delegated_mpsi -n $PARTIES -k $K -u $U -m $((K * 14)) -s 10 -r $REPS --share-width 1 \
+        -f bench_bloom_$K.csv > /dev/null
+    ./delegated_mpsi -n $PARTIES -k $K -u $U -m $((K * 14)) -s 10 -r $REPS --encoding fuse \
+        --fuse-fingerprint-bytes 1 -f bench_fuse1_$K.csv > /dev/null
+    ./delegated_mpsi -n $PARTIES -k $K -u $U -m $((K * 14)) -s 10 -r $REPS --encoding fuse \
+        --fuse-fingerprint-bytes 2 -f bench_fuse2_$K.csv > /dev/null
+    echo "set size $K done"
+done
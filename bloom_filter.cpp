@@ -0,0 +1,61 @@
+/*
+  Out-of-line batch hashing for batch_bloom_filter (bloom_filter.hpp). This is the
+  only translation unit that compiles the SSE4.1 path (build.sh passes -msse4.2),
+  so every includer of the header uses one definition.
+*/
+
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+#include "bloom_filter.hpp"
+
+void batch_bloom_filter::hash_many(const std::uint64_t* keys, const std::size_t n, bloom_type* h1, bloom_type* h2) const
+{
+   const bloom_type s1 = salt_[0];
+   const bloom_type s2 = salt_[1 % salt_.size()];
+   std::size_t i = 0;
+
+#if defined(__SSE4_1__)
+   const __m128i c1 = _mm_set1_epi32(static_cast<int>(0x9E3779B1));
+   const __m128i c2 = _mm_set1_epi32(static_cast<int>(0x85EBCA77));
+   const __m128i c3 = _mm_set1_epi32(static_cast<int>(0xC2B2AE3D));
+   const __m128i c4 = _mm_set1_epi32(static_cast<int>(0x27D4EB2F));
+   const __m128i m1 = _mm_set1_epi32(static_cast<int>(0x85EBCA6B));
+   const __m128i m2 = _mm_set1_epi32(static_cast<int>(0xC2B2AE35));
+   const __m128i v1 = _mm_set1_epi32(static_cast<int>(s1));
+   const __m128i v2 = _mm_set1_epi32(static_cast<int>(s2));
+   const __m128i one = _mm_set1_epi32(1);
+
+   for (; i + 4 <= n; i += 4)
+   {
+      const __m128 a = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)));
+      const __m128 b = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i + 2)));
+      const __m128i lo = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+      const __m128i hi = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+
+      __m128i x = _mm_xor_si128(_mm_xor_si128(_mm_mullo_epi32(lo, c1), _mm_mullo_epi32(hi, c2)), v1);
+      __m128i y = _mm_xor_si128(_mm_xor_si128(_mm_mullo_epi32(lo, c3), _mm_mullo_epi32(hi, c4)), v2);
+
+      x = _mm_xor_si128(x, _mm_srli_epi32(x, 16)); x = _mm_mullo_epi32(x, m1);
+      x = _mm_xor_si128(x, _mm_srli_epi32(x, 13)); x = _mm_mullo_epi32(x, m2);
+      x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+      y = _mm_xor_si128(y, _mm_srli_epi32(y, 16)); y = _mm_mullo_epi32(y, m1);
+      y = _mm_xor_si128(y, _mm_srli_epi32(y, 13)); y = _mm_mullo_epi32(y, m2);
+      y = _mm_xor_si128(y, _mm_srli_epi32(y, 16));
+      y = _mm_or_si128(y, one);
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(h1 + i), x);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(h2 + i), y);
+   }
+#endif
+
+   for (; i < n; ++i)
+   {
+      const bloom_type lo = static_cast<bloom_type>(keys[i]);
+      const bloom_type hi = static_cast<bloom_type>(keys[i] >> 32);
+
+      h1[i] = fmix32((lo * 0x9E3779B1) ^ (hi * 0x85EBCA77) ^ s1);
+      h2[i] = fmix32((lo * 0xC2B2AE3D) ^ (hi * 0x27D4EB2F) ^ s2) | 1;
+   }
+}
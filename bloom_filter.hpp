@@ -27,6 +27,8 @@ https://github.com/ArashPartow/bloom/blob/master/bloom_filter.hpp
 #include <cstddef>
 #include <cstdlib>
 #include <iterator>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 #include <string>
 #include <vector>
@@ -641,6 +643,195 @@ inline bloom_filter operator ^ (const bloom_filter& a, const bloom_filter& b)
    return result;
 }
 
+/*
+  batch_bloom_filter: same parameters as bloom_filter, but keeps its bits in a
+  64-bit word table and hashes/probes 64-bit keys in batches. Each key is
+  hashed once into two 32-bit values (four keys per SSE4.1 step when
+  available) and the k positions are derived by double hashing. Positions for
+  a whole block of keys are computed and prefetched before the table is
+  touched, so the cache misses of a block overlap instead of serializing.
+*/
+class batch_bloom_filter : public bloom_filter
+{
+public:
+
+   batch_bloom_filter()
+   {}
+
+   batch_bloom_filter(const bloom_parameters& p)
+   : bloom_filter(p)
+   {
+      word_table_.resize((table_size_ + 63) / 64, 0);
+
+      // The byte table of the base class is not used
+      table_type().swap(bit_table_);
+   }
+
+   inline void clear()
+   {
+      std::fill(word_table_.begin(), word_table_.end(), 0);
+      inserted_element_count_ = 0;
+   }
+
+   inline void insert_many(const std::uint64_t* keys, const std::size_t count)
+   {
+      std::vector<std::uint64_t> positions(batch_size * salt_count_);
+
+      for (std::size_t begin = 0; begin < count; begin += batch_size)
+      {
+         const std::size_t n = std::min(static_cast<std::size_t>(batch_size), count - begin);
+
+         compute_batch_positions(keys + begin, n, positions.data());
+
+         for (std::size_t i = 0; i < n * salt_count_; ++i)
+         {
+            word_table_[positions[i] >> 6] |= (1ULL << (positions[i] & 63));
+         }
+      }
+
+      inserted_element_count_ += count;
+   }
+
+   // Safe to call concurrently: the position scratch belongs to the call
+   inline void contains_many(const std::uint64_t* keys, const std::size_t count, unsigned char* results) const
+   {
+      std::vector<std::uint64_t> positions(batch_size * salt_count_);
+
+      for (std::size_t begin = 0; begin < count; begin += batch_size)
+      {
+         const std::size_t n = std::min(static_cast<std::size_t>(batch_size), count - begin);
+
+         compute_batch_positions(keys + begin, n, positions.data());
+
+         for (std::size_t i = 0; i < n; ++i)
+         {
+            std::uint64_t hit = 1;
+
+            for (std::size_t j = 0; j < salt_count_; ++j)
+            {
+               const std::uint64_t pos = positions[i * salt_count_ + j];
+               hit &= (word_table_[pos >> 6] >> (pos & 63));
+            }
+
+            results[begin + i] = static_cast<unsigned char>(hit & 1);
+         }
+      }
+   }
+
+   inline void insert(const std::uint64_t key)
+   {
+      insert_many(&key, 1);
+   }
+
+   inline void insert(const unsigned char* key_begin, const std::size_t& length)
+   {
+      const std::uint64_t key = fold_key(key_begin, length);
+      insert_many(&key, 1);
+   }
+
+   inline bool contains(const std::uint64_t key) const
+   {
+      unsigned char result = 0;
+      contains_many(&key, 1, &result);
+      return result != 0;
+   }
+
+   inline virtual bool contains(const unsigned char* key_begin, const std::size_t length) const
+   {
+      return contains(fold_key(key_begin, length));
+   }
+
+   // Bit positions of a key, as used by insert/contains
+   inline void positions(const std::uint64_t key, std::vector<std::size_t>& out) const
+   {
+      bloom_type h1 = 0;
+      bloom_type h2 = 0;
+
+      hash_many(&key, 1, &h1, &h2);
+
+      out.resize(salt_count_);
+
+      for (std::size_t j = 0; j < salt_count_; ++j)
+      {
+         out[j] = static_cast<std::size_t>(position(h1, h2, j));
+      }
+   }
+
+   inline std::vector<bool> to_bits() const
+   {
+      std::vector<bool> bits(table_size_, false);
+
+      for (std::size_t i = 0; i < table_size_; ++i)
+      {
+         bits[i] = ((word_table_[i >> 6] >> (i & 63)) & 1) != 0;
+      }
+
+      return bits;
+   }
+
+   inline const std::uint64_t* words() const
+   {
+      return word_table_.data();
+   }
+
+protected:
+
+   static const std::size_t batch_size = 32;
+
+   static inline bloom_type fmix32(bloom_type h)
+   {
+      h ^= h >> 16; h *= 0x85EBCA6B;
+      h ^= h >> 13; h *= 0xC2B2AE35;
+      h ^= h >> 16;
+      return h;
+   }
+
+   inline std::uint64_t fold_key(const unsigned char* key_begin, const std::size_t length) const
+   {
+      std::uint64_t key = 0;
+
+      if (sizeof(key) == length)
+         std::memcpy(&key, key_begin, sizeof(key));
+      else
+         key = (static_cast<std::uint64_t>(hash_ap(key_begin, length, salt_[0])) << 32) |
+               hash_ap(key_begin, length, salt_[1 % salt_.size()]);
+
+      return key;
+   }
+
+   inline std::uint64_t position(const bloom_type h1, const bloom_type h2, const std::size_t j) const
+   {
+      const bloom_type h = h1 + static_cast<bloom_type>(j) * h2;
+      return (static_cast<std::uint64_t>(h) * table_size_) >> 32;
+   }
+
+   // h1 = fmix32(lo * C1 ^ hi * C2 ^ salt0), h2 = fmix32(lo * C3 ^ hi * C4 ^ salt1) | 1.
+   // Defined in bloom_filter.cpp, the one translation unit built with SSE4.1, so every
+   // includer links the same (vectorized) definition.
+   void hash_many(const std::uint64_t* keys, const std::size_t n, bloom_type* h1, bloom_type* h2) const;
+
+   // 'positions' holds batch_size * salt_count_ entries
+   inline void compute_batch_positions(const std::uint64_t* keys, const std::size_t n, std::uint64_t* positions) const
+   {
+      bloom_type h1[batch_size];
+      bloom_type h2[batch_size];
+
+      hash_many(keys, n, h1, h2);
+
+      for (std::size_t i = 0; i < n; ++i)
+      {
+         for (std::size_t j = 0; j < salt_count_; ++j)
+         {
+            const std::uint64_t pos = position(h1[i], h2[i], j);
+            positions[i * salt_count_ + j] = pos;
+            __builtin_prefetch(&word_table_[pos >> 6]);
+         }
+      }
+   }
+
+   std::vector<std::uint64_t> word_table_;
+};
+
 class compressible_bloom_filter : public bloom_filter
 {
 public:
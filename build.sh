@@ -1,14 +1,33 @@
 #!/bin/sh
-rm delegated_mpsi secret_sharing_simd.o approx_mpsi.o Channels.o FullMesh.o #test_secret_sharing.o
+# USE_BLOOM_FILTER_LIB=1 ./build.sh enables --bloom-layout library (bloom_filter.hpp)
+BLOOM_LIB="-DUSE_BLOOM_FILTER_LIB=${USE_BLOOM_FILTER_LIB:-0}"
+rm delegated_mpsi secret_sharing_simd.o approx_mpsi.o Channels.o FullMesh.o param_planner.o delta_share.o ByteStringArena.o BinaryFuseFilter.o MappedFile.o ZeroShareStore.o share_stream.o BufferPool.o share_aggregation.o query_encoding.o ShareEpochServer.o ShardLayout.o TaskRuntime.o CorrelatedSeeds.o SessionHost.o SpeedModel.o bloom_filter.o #test_secret_sharing.o
 g++ -c hash_funcs.cpp -o hash_funcs.o -std=c++17 -g
 g++ -msse4.2 -c secret_sharing_simd.cpp  -o secret_sharing_simd.o -std=c++17 -g
 g++ -c Channels.cpp -o Channels.o -std=c++17 -g
+g++ -c BufferPool.cpp -o BufferPool.o -std=c++17 -g
 g++ -c FullMesh.cpp -o FullMesh.o -std=c++17 -g
-g++ -c Set.cpp -o Set.o -std=c++17 -g -I/usr/lib/include/
-g++ -c approx_mpsi.cpp -o approx_mpsi.o -std=c++17 -g -I/usr/lib/include/
+g++ -c ByteStringArena.cpp -o ByteStringArena.o -std=c++17 -g
+g++ -c BinaryFuseFilter.cpp -o BinaryFuseFilter.o -std=c++17 -g
+g++ -c MappedFile.cpp -o MappedFile.o -std=c++17 -g
+g++ -msse4.2 -c ZeroShareStore.cpp -o ZeroShareStore.o -std=c++17 -g
+g++ -msse4.2 -c share_stream.cpp -o share_stream.o -std=c++17 -g
+g++ -msse4.2 -c share_aggregation.cpp -o share_aggregation.o -std=c++17 -g
+g++ -c query_encoding.cpp -o query_encoding.o -std=c++17 -g
+g++ -c ShareEpochServer.cpp -o ShareEpochServer.o -std=c++17 -g
+g++ -c ShardLayout.cpp -o ShardLayout.o -std=c++17 -g
+g++ -c TaskRuntime.cpp -o TaskRuntime.o -std=c++17 -g
+g++ -msse4.2 -c CorrelatedSeeds.cpp -o CorrelatedSeeds.o -std=c++17 -g
+g++ -msse4.2 -c bloom_filter.cpp -o bloom_filter.o -std=c++17 -g
+g++ -msse4.2 -c Set.cpp -o Set.o -std=c++17 -g -I/usr/lib/include/ $BLOOM_LIB
+g++ -msse4.2 -c delta_share.cpp -o delta_share.o -std=c++17 -g -I/usr/lib/include/ $BLOOM_LIB
+g++ -msse4.2 -c param_planner.cpp -o param_planner.o -std=c++17 -g -I/usr/lib/include/ $BLOOM_LIB
+g++ -c approx_mpsi.cpp -o approx_mpsi.o -std=c++17 -g -I/usr/lib/include/ $BLOOM_LIB
+g++ -c SessionHost.cpp -o SessionHost.o -std=c++17 -g -I/usr/lib/include/ $BLOOM_LIB
+g++ -c SpeedModel.cpp -o SpeedModel.o -std=c++17 -g -I/usr/lib/include/ $BLOOM_LIB
 
 # -L/usr/lib/x86_64-linux-gnu/
-g++ -o delegated_mpsi main.cpp secret_sharing_simd.o approx_mpsi.o Channels.o FullMesh.o Set.o hash_funcs.o -g -lblake3 -lboost_program_options -lssl3 -lcrypto -lsodium -I/usr/lib/include/ -L/usr/bin/lib/ -std=c++17
+g++ -o delegated_mpsi main.cpp secret_sharing_simd.o approx_mpsi.o Channels.o FullMesh.o Set.o hash_funcs.o param_planner.o delta_share.o ByteStringArena.o BinaryFuseFilter.o MappedFile.o ZeroShareStore.o share_stream.o BufferPool.o share_aggregation.o query_encoding.o ShareEpochServer.o ShardLayout.o TaskRuntime.o CorrelatedSeeds.o SessionHost.o SpeedModel.o bloom_filter.o -g -lblake3 -lboost_program_options -lssl3 -lcrypto -lsodium -I/usr/lib/include/ -L/usr/bin/lib/ -std=c++17 $BLOOM_LIB
 #-L/data/MPSI_Bay/boost_1_87_0/stage/lib/
 #g++ -c test_secret_sharing.cpp -o test_secret_sharing.o
 #For test...
@@ -0,0 +1,9 @@
+#!/bin/sh
+rm bench_bloom_filter Set.o hash_funcs.o ByteStringArena.o secret_sharing_simd.o bloom_filter.o TaskRuntime.o
+g++ -c hash_funcs.cpp -o hash_funcs.o -std=c++17 -O2
+g++ -msse4.2 -c secret_sharing_simd.cpp -o secret_sharing_simd.o -std=c++17 -O2
+g++ -c ByteStringArena.cpp -o ByteStringArena.o -std=c++17 -O2
+g++ -msse4.2 -c bloom_filter.cpp -o bloom_filter.o -std=c++17 -O2
+g++ -c TaskRuntime.cpp -o TaskRuntime.o -std=c++17 -O2
+g++ -msse4.2 -c Set.cpp -o Set.o -std=c++17 -O2 -I/usr/lib/include/ -DUSE_BLOOM_FILTER_LIB=1
+g++ -msse4.2 -o bench_bloom_filter bench_bloom_filter.cpp Set.o hash_funcs.o ByteStringArena.o secret_sharing_simd.o bloom_filter.o TaskRuntime.o -std=c++17 -O2 -I/usr/lib/include/ -DUSE_BLOOM_FILTER_LIB=1 -lblake3 -lssl3 -lcrypto -lsodium
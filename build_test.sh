@@ -1,6 +1,16 @@
 #!/bin/sh
-rm secret_sharing_simd.o approx_mpsi.o #test_secret_sharing.o
-g++ -msse4.2 -c secret_sharing_simd.cpp  -o secret_sharing_simd.o
-g++ -c approx_mpsi.cpp -o approx_mpsi.o
-g++ -c test_secret_sharing.cpp -o test_secret_sharing.o -I/data/MPSI_Bay/googletest-1.15.2/googletest/include/gtest/
-g++ -o test_secret_sharing secret_sharing_simd.o test_secret_sharing.o approx_mpsi.o -lgtest -lblake3
+rm secret_sharing_simd.o hash_funcs.o Set.o ByteStringArena.o delta_share.o TaskRuntime.o CorrelatedSeeds.o query_encoding.o BinaryFuseFilter.o ShardLayout.o MappedFile.o ShareEpochServer.o test_secret_sharing.o
+g++ -msse4.2 -c secret_sharing_simd.cpp  -o secret_sharing_simd.o -std=c++17
+g++ -c hash_funcs.cpp -o hash_funcs.o -std=c++17
+g++ -msse4.2 -c Set.cpp -o Set.o -std=c++17 -I/usr/lib/include/
+g++ -c ByteStringArena.cpp -o ByteStringArena.o -std=c++17
+g++ -msse4.2 -c delta_share.cpp -o delta_share.o -std=c++17 -I/usr/lib/include/
+g++ -c TaskRuntime.cpp -o TaskRuntime.o -std=c++17
+g++ -msse4.2 -c CorrelatedSeeds.cpp -o CorrelatedSeeds.o -std=c++17
+g++ -c query_encoding.cpp -o query_encoding.o -std=c++17
+g++ -c BinaryFuseFilter.cpp -o BinaryFuseFilter.o -std=c++17
+g++ -c ShardLayout.cpp -o ShardLayout.o -std=c++17
+g++ -c MappedFile.cpp -o MappedFile.o -std=c++17
+g++ -c ShareEpochServer.cpp -o ShareEpochServer.o -std=c++17
+g++ -msse4.2 -c test_secret_sharing.cpp -o test_secret_sharing.o -std=c++17 -I/usr/lib/include/ -I/data/MPSI_Bay/googletest-1.15.2/googletest/include/gtest/
+g++ -o test_secret_sharing secret_sharing_simd.o test_secret_sharing.o hash_funcs.o Set.o ByteStringArena.o delta_share.o TaskRuntime.o CorrelatedSeeds.o query_encoding.o BinaryFuseFilter.o ShardLayout.o MappedFile.o ShareEpochServer.o -lgtest -lblake3 -lssl3 -lcrypto -lsodium -pthread
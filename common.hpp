@@ -16,6 +16,50 @@ struct Options {
     size_t repetitions;
     std::string results_filename;
     bool stats;
+    std::string bloom_layout;       // "standard", "blocked" or "library" (USE_BLOOM_FILTER_LIB)
+    size_t bloom_block_bins;        // Bins per block in the blocked layout
+    size_t share_width;             // Share bytes per bin (0 = legacy byte-per-bit shares)
+    double target_fpr;              // Planner target (0 = use the given bin/hash counts)
+    double cost_hash_ns;            // Planner cost model
+    double cost_xof_ns_per_byte;
+    double cost_probe_ns;
+    double cost_xor_ns_per_byte;
+    std::string element_type;       // "u64" or "bytes" (arena-backed byte strings)
+    size_t delta_churn;             // Elements each client swaps in an incremental update (0 = off)
+    std::string encoding;           // "bloom" or "fuse" (binary fuse filter)
+    size_t fuse_fingerprint_bytes;  // Cell width of the fuse encoding
+    std::string phase;              // "both", "offline" (precompute zero shares) or "online"
+    std::string offline_dir;        // Where the offline phase stores zero shares
+    size_t session_id;              // First session (repetition i uses session_id + i)
+    size_t stream_chunk_bins;       // Bins per streamed share chunk (0 = send the share whole)
+    size_t aggregation_threads;     // Server threads folding shares (0 = hardware concurrency)
+    bool aggregation_tree;          // Tree-reduce shares that arrive together before folding
+    std::string query_encoding;     // "indices", "packed" (bit-packed indices) or "digest" (16 bytes per element)
+    size_t queriers;                // Parties 1..queriers query the aggregated share
+    size_t query_batches;           // Batches each querier splits its query into
+    size_t query_threads;           // Server workers answering query batches
+    size_t result_chunk;            // Query results per server reply (0 = one reply per batch)
+    size_t daemon_epochs;           // Run as a long-lived server for this many epochs (0 = off)
+    std::string snapshot_dir;       // Where the daemon persists the live aggregate
+    bool snapshot_verify;           // Checksum the snapshot on restore
+    bool snapshot_populate;         // Fault the whole snapshot in on restore (MAP_POPULATE)
+    size_t server_shards;           // Servers splitting the share by bin range
+    size_t aggregation_fan_in;      // Children per node of the aggregation tree (0 = all to the server)
+    size_t party_workers;           // Workers running the send-only parties (0 = one thread per party)
+    size_t concurrent_repetitions;  // Repetitions run at once, each on its own network lane
+    bool reuse_parties;             // Keep inputs and parties across repetitions
+    std::string session_file;       // Host the sessions listed here in one process ("" = single instance)
+    size_t session_memory_mb;       // Memory budget shared by the hosted sessions (0 = unlimited)
+    size_t max_sessions;            // Hosted sessions running at once
+    double round_deadline_ms;       // Server stops waiting for shares this long into the round (0 = wait for all)
+    size_t min_on_time_senders;     // With a deadline, fewer senders on time abort the round
+    double straggler_fraction;      // Probability that a client is slow in a round (simulation)
+    double straggler_delay_ms;      // How long a slow client holds its share back
+    std::string speed_profile;      // Per-party speeds and per-link overrides ("" = none)
+    double slowdown_sigma;          // Log-normal spread of party compute slowdowns (0 = all at host speed)
+    double latency_sigma;           // Log-normal spread of party link latencies around --latency
+    double bandwidth_sigma;         // Log-normal spread of party bandwidths around --bytes-per-sec
+    size_t speed_seed;              // Seed of the sampled speeds (0 = random)
 };
 
 extern Options &g_options;
@@ -0,0 +1,172 @@
+#include <iostream>
+#include <random>
+#include <cstring>
+#include <cassert>
+#include <stdexcept>
+#include <unordered_set>
+#include <algorithm>
+#include "delta_share.hpp"
+
+/* Method Definitions for 'CountingBloomFilter' class */
+CountingBloomFilter::CountingBloomFilter(size_t bin_count) : counts(bin_count, 0) {}
+
+void CountingBloomFilter::add(const std::vector<size_t>& indices, std::vector<size_t>& flipped) {
+    for (size_t idx : indices) {
+        if (counts[idx] == UINT8_MAX) continue;
+        if (counts[idx]++ == 0) {
+            flipped.push_back(idx);
+        }
+    }
+}
+
+void CountingBloomFilter::remove(const std::vector<size_t>& indices, std::vector<size_t>& flipped) {
+    for (size_t idx : indices) {
+        if (counts[idx] == UINT8_MAX || counts[idx] == 0) continue;
+        if (--counts[idx] == 0) {
+            flipped.push_back(idx);
+        }
+    }
+}
+
+size_t CountingBloomFilter::match(const std::vector<bool>& filter) {
+    assert(filter.size() == counts.size());
+    size_t changed = 0;
+    for (size_t bin = 0; bin < counts.size(); ++bin) {
+        if (filter[bin] && counts[bin] == 0) {
+            counts[bin] = UINT8_MAX;
+            ++changed;
+        } else if (!filter[bin] && counts[bin] != 0) {
+            counts[bin] = 0;
+            ++changed;
+        }
+    }
+    return changed;
+}
+
+bool CountingBloomFilter::test(size_t bin) const {
+    return counts[bin] != 0;
+}
+
+size_t CountingBloomFilter::size() const {
+    return counts.size();
+}
+
+/* Method Definitions for 'ShareDelta' struct */
+std::vector<uint8_t> ShareDelta::serialize() const {
+    uint64_t header[2] = {width, bins.size()};
+    std::vector<uint8_t> data(sizeof(header) + bins.size() * sizeof(uint32_t) + xor_bytes.size());
+
+    uint8_t* out = data.data();
+    std::memcpy(out, header, sizeof(header));
+    out += sizeof(header);
+    std::memcpy(out, bins.data(), bins.size() * sizeof(uint32_t));
+    out += bins.size() * sizeof(uint32_t);
+    std::memcpy(out, xor_bytes.data(), xor_bytes.size());
+    return data;
+}
+
+ShareDelta ShareDelta::deserialize(const std::vector<uint8_t>& data) {
+    uint64_t header[2];
+    if (data.size() < sizeof(header)) {
+        throw std::runtime_error("ShareDelta::deserialize: truncated header");
+    }
+    std::memcpy(header, data.data(), sizeof(header));
+
+    ShareDelta delta;
+    delta.width = header[0];
+    size_t count = header[1];
+    if (data.size() != sizeof(header) + count * (sizeof(uint32_t) + delta.width)) {
+        throw std::runtime_error("ShareDelta::deserialize: size mismatch");
+    }
+
+    const uint8_t* in = data.data() + sizeof(header);
+    delta.bins.resize(count);
+    std::memcpy(delta.bins.data(), in, count * sizeof(uint32_t));
+    in += count * sizeof(uint32_t);
+    delta.xor_bytes.assign(in, in + count * delta.width);
+    return delta;
+}
+
+/* Method Definitions for 'DeltaShareClient' class */
+DeltaShareClient::DeltaShareClient(const Set& input, const std::vector<bool>& sent_filter, size_t width, size_t hash_count,
+                                   const std::string& hash_func, const SimdBytes& zero_share, const SimdBytes& sent_share)
+    : input(input), filter_bins(sent_filter.size()), width(width), hash_count(hash_count), hash_func(hash_func),
+      counting_filter(filter_bins), zero_bins(filter_bins * width), current_share(sent_share.bytes) {
+    assert(current_share.size() == filter_bins * width && "Sent share does not match the filter layout");
+
+    /* Legacy shares wrap the zero share around the filter (byte i uses zero byte i % size) */
+    for (size_t i = 0; i < zero_bins.size(); ++i) {
+        zero_bins[i] = zero_share.bytes[i % zero_share.bytes.size()];
+    }
+
+    std::vector<size_t> unused;
+    for (size_t element : input.to_vector()) {
+        counting_filter.add(input.bloom_filter_indices(element, filter_bins, hash_count, hash_func), unused);
+    }
+    /* The sent share is what the server holds; a bin the indices disagree on would otherwise
+       be patched from the wrong state */
+    size_t mismatched = counting_filter.match(sent_filter);
+    if (mismatched > 0) {
+        std::cout << "DeltaShareClient::DeltaShareClient(): " << mismatched
+                  << " bins differed from the sent filter and follow it\n";
+    }
+}
+
+ShareDelta DeltaShareClient::update(const std::vector<size_t>& added, const std::vector<size_t>& removed) {
+    /* A bin can flip several times in one update; only an odd number of flips changes it */
+    std::vector<size_t> flipped;
+    for (size_t element : removed) {
+        if (!input.contains(element)) continue;
+        counting_filter.remove(input.bloom_filter_indices(element, filter_bins, hash_count, hash_func), flipped);
+        input.erase(element);
+    }
+    for (size_t element : added) {
+        if (input.contains(element)) continue;
+        counting_filter.add(input.bloom_filter_indices(element, filter_bins, hash_count, hash_func), flipped);
+        input.insert(element);
+    }
+
+    std::unordered_set<size_t> changed;
+    for (size_t bin : flipped) {
+        if (!changed.erase(bin)) changed.insert(bin);
+    }
+    std::vector<size_t> changed_bins(changed.begin(), changed.end());
+    std::sort(changed_bins.begin(), changed_bins.end());
+
+    ShareDelta delta;
+    delta.width = width;
+    delta.bins.reserve(changed_bins.size());
+    delta.xor_bytes.resize(changed_bins.size() * width);
+
+    /* Newly set bins go back to the zero share; newly empty bins get a fresh mask */
+    std::random_device rd;
+    for (size_t c = 0; c < changed_bins.size(); ++c) {
+        size_t bin = changed_bins[c];
+        bool is_set = counting_filter.test(bin);
+        delta.bins.push_back(static_cast<uint32_t>(bin));
+        for (size_t j = 0; j < width; ++j) {
+            size_t pos = bin * width + j;
+            uint8_t next = is_set ? zero_bins[pos] : static_cast<uint8_t>(zero_bins[pos] ^ (rd() & 0xFF));
+            delta.xor_bytes[c * width + j] = next ^ current_share[pos];
+            current_share[pos] = next;
+        }
+    }
+
+    std::cout << "DeltaShareClient::update(): added=" << added.size() << ", removed=" << removed.size()
+              << ", changed bins=" << changed_bins.size() << "\n";
+    return delta;
+}
+
+const Set& DeltaShareClient::elements() const {
+    return input;
+}
+
+void apply_share_delta(SimdBytes& aggregated_share, const ShareDelta& delta) {
+    for (size_t c = 0; c < delta.bins.size(); ++c) {
+        size_t base = static_cast<size_t>(delta.bins[c]) * delta.width;
+        assert(base + delta.width <= aggregated_share.bytes.size());
+        for (size_t j = 0; j < delta.width; ++j) {
+            aggregated_share.bytes[base + j] ^= delta.xor_bytes[c * delta.width + j];
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef DELTA_SHARE_HPP
+#define DELTA_SHARE_HPP
+
+#include <vector>
+#include <cstdint>
+#include <string>
+#include "Set.hpp"
+#include "secret_sharing_simd.hpp"
+
+// Counting bloom filter over the same bins as Set::to_bloom_filter(); tracks which bins
+// change membership when elements are added or removed. Counters saturate at 255 and a
+// saturated counter is never decremented (the bin then stays set).
+class CountingBloomFilter {
+public:
+    CountingBloomFilter() = default;
+    explicit CountingBloomFilter(size_t bin_count);
+
+    // Appends the bins that went from empty to set (add) or from set to empty (remove)
+    void add(const std::vector<size_t>& indices, std::vector<size_t>& flipped);
+    void remove(const std::vector<size_t>& indices, std::vector<size_t>& flipped);
+
+    // Make test() agree with 'filter': set bins no element reached are pinned (saturated),
+    // cleared bins are emptied. Returns how many bins had to change.
+    size_t match(const std::vector<bool>& filter);
+
+    bool test(size_t bin) const;
+    size_t size() const;
+
+private:
+    std::vector<uint8_t> counts;
+};
+
+// XOR delta over the bins whose corrupted share changed; width bytes per bin
+struct ShareDelta {
+    size_t width = 1;
+    std::vector<uint32_t> bins;
+    std::vector<uint8_t> xor_bytes;
+
+    std::vector<uint8_t> serialize() const;
+    static ShareDelta deserialize(const std::vector<uint8_t>& data);
+};
+
+// Client state kept between sessions: counting filter, per-bin zero share and the share
+// the server currently holds. update() returns only the bins that changed. 'sent_filter'
+// is the bloom filter the sent share was corrupted with; the counting filter follows it.
+class DeltaShareClient {
+public:
+    DeltaShareClient(const Set& input, const std::vector<bool>& sent_filter, size_t width, size_t hash_count,
+                     const std::string& hash_func, const SimdBytes& zero_share, const SimdBytes& sent_share);
+
+    ShareDelta update(const std::vector<size_t>& added, const std::vector<size_t>& removed);
+
+    const Set& elements() const;
+
+private:
+    Set input;
+    size_t filter_bins;
+    size_t width;
+    size_t hash_count;
+    std::string hash_func;
+    CountingBloomFilter counting_filter;
+    std::vector<uint8_t> zero_bins;     // Zero share laid out width bytes per bin
+    std::vector<uint8_t> current_share; // What the server has for this client
+};
+
+// Patch an aggregated share in place
+void apply_share_delta(SimdBytes& aggregated_share, const ShareDelta& delta);
+
+#endif // DELTA_SHARE_HPP
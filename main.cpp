@@ -10,6 +10,9 @@
 
 #include "approx_mpsi.hpp"
 #include "common.hpp"
+#include "param_planner.hpp"
+#include "SessionHost.hpp"
+#include "SpeedModel.hpp"
 
 Options &g_options = *(new Options());
 Stats g_stats;
@@ -32,7 +35,51 @@ std::optional<Options> parse_options(int argc, char* argv[]) {
         ("bytes-per-sec,b", po::value<double>(&options.bytes_per_sec)->default_value(0.0), "Bandwidth in bytes per second")
         ("repetitions,r", po::value<size_t>(&options.repetitions)->required(), "Number of repetitions")
         ("results-filename,f", po::value<std::string>(&options.results_filename)->required(), "Output results filename")
-        ("stats,t", po::value<bool>(&options.stats)->default_value(false), "Output stats");
+        ("stats,t", po::value<bool>(&options.stats)->default_value(false), "Output stats")
+        ("bloom-layout", po::value<std::string>(&options.bloom_layout)->default_value("standard"), "Bloom filter layout (standard, blocked, library)")
+        ("bloom-block-bins", po::value<size_t>(&options.bloom_block_bins)->default_value(DEFAULT_BLOOM_BLOCK_BINS), "Bins per block for the blocked bloom layout")
+        ("share-width", po::value<size_t>(&options.share_width)->default_value(0), "Share bytes per bin (0 = one byte per filter bit)")
+        ("target-fpr", po::value<double>(&options.target_fpr)->default_value(0.0), "Plan bin count, hash count and share width for this false positive probability")
+        ("cost-hash-ns", po::value<double>(&options.cost_hash_ns)->default_value(CostModel().hash_ns), "Planner: ns per element hash")
+        ("cost-xof-ns-per-byte", po::value<double>(&options.cost_xof_ns_per_byte)->default_value(CostModel().xof_ns_per_byte), "Planner: ns per zero-share byte per seed")
+        ("cost-probe-ns", po::value<double>(&options.cost_probe_ns)->default_value(CostModel().probe_ns), "Planner: ns per random share access")
+        ("cost-xor-ns-per-byte", po::value<double>(&options.cost_xor_ns_per_byte)->default_value(CostModel().xor_ns_per_byte), "Planner: ns per aggregated share byte")
+        ("element-type", po::value<std::string>(&options.element_type)->default_value("u64"), "Set element type (u64, bytes)")
+        ("delta-churn", po::value<size_t>(&options.delta_churn)->default_value(0), "Elements each client replaces in an incremental delta update (0 = off)")
+        ("encoding", po::value<std::string>(&options.encoding)->default_value("bloom"), "Set encoding (bloom, fuse)")
+        ("fuse-fingerprint-bytes", po::value<size_t>(&options.fuse_fingerprint_bytes)->default_value(1), "Fingerprint bytes per cell of the fuse encoding")
+        ("phase", po::value<std::string>(&options.phase)->default_value("both"), "Run phase (both, offline, online)")
+        ("offline-dir", po::value<std::string>(&options.offline_dir)->default_value("."), "Directory for precomputed zero shares")
+        ("session-id", po::value<size_t>(&options.session_id)->default_value(0), "Session of the first repetition")
+        ("stream-chunk-bins", po::value<size_t>(&options.stream_chunk_bins)->default_value(0), "Stream shares in chunks of this many bins (0 = off)")
+        ("aggregation-threads", po::value<size_t>(&options.aggregation_threads)->default_value(1), "Server threads aggregating shares (0 = all cores)")
+        ("aggregation-tree", po::value<bool>(&options.aggregation_tree)->default_value(false), "Tree-reduce shares arriving together before folding")
+        ("query-encoding", po::value<std::string>(&options.query_encoding)->default_value("indices"), "Query wire format (indices, packed, digest)")
+        ("queriers", po::value<size_t>(&options.queriers)->default_value(1), "Parties 1..N query the aggregated share")
+        ("query-batches", po::value<size_t>(&options.query_batches)->default_value(1), "Batches each querier sends its query in")
+        ("query-threads", po::value<size_t>(&options.query_threads)->default_value(1), "Server threads answering query batches")
+        ("result-chunk", po::value<size_t>(&options.result_chunk)->default_value(0), "Query results per server reply, streamed as evaluated (0 = whole batch)")
+        ("daemon-epochs", po::value<size_t>(&options.daemon_epochs)->default_value(0), "Run the server as a daemon for this many epochs (0 = off)")
+        ("snapshot-dir", po::value<std::string>(&options.snapshot_dir)->default_value("."), "Directory for the daemon's persisted aggregate")
+        ("snapshot-verify", po::value<bool>(&options.snapshot_verify)->default_value(true), "Checksum the snapshot before serving it")
+        ("snapshot-populate", po::value<bool>(&options.snapshot_populate)->default_value(false), "Fault the snapshot in on restore instead of lazily")
+        ("server-shards", po::value<size_t>(&options.server_shards)->default_value(1), "Server shards splitting the share by bin range")
+        ("aggregation-fan-in", po::value<size_t>(&options.aggregation_fan_in)->default_value(0), "Fan-in of the client aggregation tree (0 = flat)")
+        ("party-workers", po::value<size_t>(&options.party_workers)->default_value(0), "Worker threads running the send-only clients (0 = one thread per party)")
+        ("concurrent-repetitions", po::value<size_t>(&options.concurrent_repetitions)->default_value(1), "Repetitions run concurrently on disjoint cores and network lanes")
+        ("reuse-parties", po::value<bool>(&options.reuse_parties)->default_value(false), "Keep inputs and parties across repetitions (steady-state benchmarking)")
+        ("session-file", po::value<std::string>(&options.session_file)->default_value(""), "Host the sessions listed in this file (one line of name=value overrides each)")
+        ("session-memory-mb", po::value<size_t>(&options.session_memory_mb)->default_value(0), "Memory budget of the hosted sessions in MB (0 = unlimited)")
+        ("max-sessions", po::value<size_t>(&options.max_sessions)->default_value(4), "Hosted sessions running at once")
+        ("round-deadline-ms", po::value<double>(&options.round_deadline_ms)->default_value(0.0), "Aggregate the shares that arrive within this many ms; late senders are corrected out (0 = wait for all)")
+        ("min-on-time-senders", po::value<size_t>(&options.min_on_time_senders)->default_value(2), "Abort a round whose deadline fewer senders than this meet (at least 2)")
+        ("straggler-fraction", po::value<double>(&options.straggler_fraction)->default_value(0.0), "Probability that a client is slow in a round")
+        ("straggler-delay-ms", po::value<double>(&options.straggler_delay_ms)->default_value(0.0), "Delay of a slow client before it sends its share")
+        ("speed-profile", po::value<std::string>(&options.speed_profile)->default_value(""), "File of per-party slowdown/latency/bandwidth and per-link overrides")
+        ("slowdown-sigma", po::value<double>(&options.slowdown_sigma)->default_value(0.0), "Log-normal spread of per-party compute slowdowns")
+        ("latency-sigma", po::value<double>(&options.latency_sigma)->default_value(0.0), "Log-normal spread of per-party latencies around --latency")
+        ("bandwidth-sigma", po::value<double>(&options.bandwidth_sigma)->default_value(0.0), "Log-normal spread of per-party bandwidths around --bytes-per-sec")
+        ("speed-seed", po::value<size_t>(&options.speed_seed)->default_value(0), "Seed of the sampled party speeds (0 = random)");
 
     po::variables_map vm;
     try {
@@ -70,7 +117,47 @@ int main(int argc, char* argv[]) {
               << "  Bytes per Sec: " << g_options.bytes_per_sec << "\n"
               << "  Repetitions: " << g_options.repetitions << "\n"
               << "  Results Filename: " << g_options.results_filename << "\n"
-              << "  Stats: " << g_options.stats << "\n";
+              << "  Stats: " << g_options.stats << "\n"
+              << "  Bloom Layout: " << g_options.bloom_layout << "\n"
+              << "  Bloom Block Bins: " << g_options.bloom_block_bins << "\n"
+              << "  Share Width: " << g_options.share_width << "\n"
+              << "  Target FPR: " << g_options.target_fpr << "\n"
+              << "  Element Type: " << g_options.element_type << "\n"
+              << "  Delta Churn: " << g_options.delta_churn << "\n"
+              << "  Encoding: " << g_options.encoding << "\n"
+              << "  Fuse Fingerprint Bytes: " << g_options.fuse_fingerprint_bytes << "\n"
+              << "  Phase: " << g_options.phase << "\n"
+              << "  Offline Dir: " << g_options.offline_dir << "\n"
+              << "  Session Id: " << g_options.session_id << "\n"
+              << "  Stream Chunk Bins: " << g_options.stream_chunk_bins << "\n"
+              << "  Aggregation Threads: " << g_options.aggregation_threads << "\n"
+              << "  Aggregation Tree: " << g_options.aggregation_tree << "\n"
+              << "  Query Encoding: " << g_options.query_encoding << "\n"
+              << "  Queriers: " << g_options.queriers << "\n"
+              << "  Query Batches: " << g_options.query_batches << "\n"
+              << "  Query Threads: " << g_options.query_threads << "\n"
+              << "  Result Chunk: " << g_options.result_chunk << "\n"
+              << "  Daemon Epochs: " << g_options.daemon_epochs << "\n"
+              << "  Snapshot Dir: " << g_options.snapshot_dir << "\n"
+              << "  Snapshot Verify: " << g_options.snapshot_verify << "\n"
+              << "  Snapshot Populate: " << g_options.snapshot_populate << "\n"
+              << "  Server Shards: " << g_options.server_shards << "\n"
+              << "  Aggregation Fan-in: " << g_options.aggregation_fan_in << "\n"
+              << "  Party Workers: " << g_options.party_workers << "\n"
+              << "  Concurrent Repetitions: " << g_options.concurrent_repetitions << "\n"
+              << "  Reuse Parties: " << g_options.reuse_parties << "\n"
+              << "  Session File: " << g_options.session_file << "\n"
+              << "  Session Memory (MB): " << g_options.session_memory_mb << "\n"
+              << "  Max Sessions: " << g_options.max_sessions << "\n"
+              << "  Round Deadline (ms): " << g_options.round_deadline_ms << "\n"
+              << "  Min On-Time Senders: " << g_options.min_on_time_senders << "\n"
+              << "  Straggler Fraction: " << g_options.straggler_fraction << "\n"
+              << "  Straggler Delay (ms): " << g_options.straggler_delay_ms << "\n"
+              << "  Speed Profile: " << g_options.speed_profile << "\n"
+              << "  Slowdown Sigma: " << g_options.slowdown_sigma << "\n"
+              << "  Latency Sigma: " << g_options.latency_sigma << "\n"
+              << "  Bandwidth Sigma: " << g_options.bandwidth_sigma << "\n"
+              << "  Speed Seed: " << g_options.speed_seed << "\n";
 
     if (g_options.domain_size < g_options.set_size) {
         std::cerr << "Error: Domain size must be greater than or equal to set size\n";
@@ -82,8 +169,190 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    if (g_options.element_type != "u64" && g_options.element_type != "bytes") {
+        std::cerr << "Error: Element type must be 'u64' or 'bytes'\n";
+        return 1;
+    }
+
+    if (g_options.phase != "both" && g_options.phase != "offline" && g_options.phase != "online") {
+        std::cerr << "Error: Phase must be 'both', 'offline' or 'online'\n";
+        return 1;
+    }
+
+    if (g_options.encoding != "bloom" && g_options.encoding != "fuse") {
+        std::cerr << "Error: Encoding must be 'bloom' or 'fuse'\n";
+        return 1;
+    }
+
+    if (g_options.encoding == "fuse") {
+        /* The fuse filter sizes itself from the set size; bloom-only knobs do not apply */
+        if (g_options.fuse_fingerprint_bytes == 0 || g_options.fuse_fingerprint_bytes > FUSE_MAX_FINGERPRINT_BYTES) {
+            std::cerr << "Error: Fuse fingerprint bytes must be between 1 and " << FUSE_MAX_FINGERPRINT_BYTES << "\n";
+            return 1;
+        }
+        if (g_options.delta_churn > 0 || g_options.target_fpr > 0.0 || g_options.share_width > 0) {
+            std::cerr << "Error: Delta churn, target FPR and share width apply to the bloom encoding only\n";
+            return 1;
+        }
+    }
+
+    if (g_options.bloom_layout != "standard" && g_options.bloom_layout != "blocked" &&
+        g_options.bloom_layout != "library") {
+        std::cerr << "Error: Bloom layout must be 'standard', 'blocked' or 'library'\n";
+        return 1;
+    }
+
+#if !USE_BLOOM_FILTER_LIB
+    if (g_options.bloom_layout == "library") {
+        std::cerr << "Error: Bloom layout 'library' needs a build with USE_BLOOM_FILTER_LIB=1\n";
+        return 1;
+    }
+#endif
+
+    if (g_options.bloom_layout == "blocked" &&
+        (g_options.bloom_block_bins == 0 || g_options.hash_count > g_options.bloom_block_bins)) {
+        std::cerr << "Error: Bloom block bins must be non-zero and at least the hash count\n";
+        return 1;
+    }
+
+    if (g_options.query_encoding != "indices" && g_options.query_encoding != "packed" &&
+        g_options.query_encoding != "digest") {
+        std::cerr << "Error: Query encoding must be 'indices', 'packed' or 'digest'\n";
+        return 1;
+    }
+
+    if (g_options.query_encoding == "digest" && g_options.encoding != "fuse" && g_options.bloom_layout != "blocked") {
+        /* Standard and library positions are not a function of the 16-byte digest */
+        std::cerr << "Error: Query encoding 'digest' needs the fuse encoding or the blocked bloom layout\n";
+        return 1;
+    }
+
+    if (g_options.queriers == 0 || g_options.queriers >= g_options.party_count || g_options.query_batches == 0) {
+        std::cerr << "Error: Queriers must be between 1 and party count - 1, and query batches non-zero\n";
+        return 1;
+    }
+
+    if (g_options.server_shards == 0) {
+        std::cerr << "Error: Server shards must be at least 1\n";
+        return 1;
+    }
+
+    if (g_options.server_shards > 1 &&
+        (g_options.delta_churn > 0 || g_options.daemon_epochs > 0 || g_options.query_batches > 1 ||
+         g_options.query_encoding != "indices")) {
+        /* Shards see index sub-patterns; deltas, the daemon and batching address one server */
+        std::cerr << "Error: Server shards need index queries in one batch, without delta churn or the daemon\n";
+        return 1;
+    }
+
+    if (g_options.server_shards > 1 && g_options.result_chunk > 0) {
+        /* Shards answer with XOR partials the querier can only test once all have arrived */
+        std::cerr << "Error: Result chunks need a single server\n";
+        return 1;
+    }
+
+    if (g_options.aggregation_fan_in > 0 && (g_options.stream_chunk_bins > 0 || g_options.server_shards > 1)) {
+        /* Intermediate nodes forward one whole share to one parent */
+        std::cerr << "Error: The aggregation tree needs whole shares and a single server\n";
+        return 1;
+    }
+
+    if (g_options.daemon_epochs > 0 && g_options.delta_churn > 0) {
+        std::cerr << "Error: Delta churn does not apply to the daemon (each epoch is a fresh aggregate)\n";
+        return 1;
+    }
+
+    if (g_options.queriers > 1 && g_options.delta_churn > 0) {
+        /* Clients report their updated sets through the same output slot queriers use */
+        std::cerr << "Error: Delta churn needs a single querier\n";
+        return 1;
+    }
+
+    if (g_options.round_deadline_ms > 0.0 &&
+        (g_options.aggregation_fan_in > 0 || g_options.stream_chunk_bins > 0 || g_options.server_shards > 1 ||
+         g_options.delta_churn > 0 || g_options.daemon_epochs > 0 || g_options.encoding == "fuse" ||
+         g_options.phase == "online")) {
+        /* The round is closed by the one server that receives every whole share directly; fuse
+           queriers fix their fingerprint parity from the full sender count. Corrections for late
+           senders expand this process's pair keys, which are not the keys the offline run dealt. */
+        std::cerr << "Error: A round deadline needs flat bloom aggregation of whole shares at a single server, without delta churn, the daemon or offline shares\n";
+        return 1;
+    }
+
+    if (g_options.round_deadline_ms > 0.0 && g_options.party_workers > 0) {
+        /* Every sender then waits for the server to close the round, so no party is send-only
+           and the workers would never run one */
+        std::cerr << "Error: A round deadline keeps every sender waiting on the server; it does not run on party workers\n";
+        return 1;
+    }
+
+    if (g_options.round_deadline_ms > 0.0 &&
+        (g_options.min_on_time_senders < 2 || g_options.min_on_time_senders > g_options.party_count - 1)) {
+        /* A round closed with one sender would hand the server that sender's filter */
+        std::cerr << "Error: Min on-time senders must be at least 2 and at most the number of senders\n";
+        return 1;
+    }
+
+    if (g_options.straggler_fraction < 0.0 || g_options.straggler_fraction > 1.0) {
+        std::cerr << "Error: Straggler fraction must be between 0 and 1\n";
+        return 1;
+    }
+
+    if (g_options.slowdown_sigma < 0.0 || g_options.latency_sigma < 0.0 || g_options.bandwidth_sigma < 0.0) {
+        std::cerr << "Error: Speed sigmas must not be negative\n";
+        return 1;
+    }
+
+    if (!g_options.session_file.empty() && (g_options.phase != "both" || g_options.daemon_epochs > 0 || g_options.max_sessions == 0)) {
+        /* Hosted sessions are complete protocol runs; the offline store and the daemon are per process */
+        std::cerr << "Error: Hosted sessions need the 'both' phase, no daemon and at least one running session\n";
+        return 1;
+    }
+
+    std::optional<ParameterPlan> plan;
+    if (g_options.target_fpr > 0.0) {
+        CostModel costs;
+        costs.hash_ns = g_options.cost_hash_ns;
+        costs.xof_ns_per_byte = g_options.cost_xof_ns_per_byte;
+        costs.probe_ns = g_options.cost_probe_ns;
+        costs.xor_ns_per_byte = g_options.cost_xor_ns_per_byte;
+        costs.bytes_per_sec = g_options.bytes_per_sec;
+        costs.latency = g_options.latency;
+        try {
+            plan = plan_parameters(g_options.set_size, g_options.party_count, g_options.set_size * SEEDS_PER_ELEMENT,
+                                   g_options.target_fpr, g_options.bloom_layout, g_options.bloom_block_bins, costs);
+        } catch (const std::invalid_argument& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+        print_plan(*plan);
+        g_options.bin_count = plan->bin_count;
+        g_options.hash_count = plan->hash_count;
+        g_options.share_width = plan->share_width;
+    } else if (g_options.share_width > 0) {
+        if (g_options.share_width > SHARE_BYTE_COUNT) {
+            std::cerr << "Error: Share width must not exceed " << SHARE_BYTE_COUNT << " bytes\n";
+            return 1;
+        }
+        g_options.bin_count = align_bin_count(g_options.bin_count, g_options.bloom_layout, g_options.bloom_block_bins);
+    }
+
     //Stats mstats = Stats(g_options.repetitions, g_options.results_filename);
     g_stats = *(new Stats(g_options.repetitions, g_options.results_filename));
+    if (!g_options.session_file.empty()) {
+        /* Each session reports to its own results file; see SessionHost */
+        std::vector<Options> sessions;
+        try {
+            sessions = SessionHost::load_sessions(g_options.session_file, g_options);
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+        SessionHost host(g_options.session_memory_mb << 20, g_options.max_sessions, g_options.party_workers);
+        size_t validated = host.run(sessions);
+        std::cout << "Hosted sessions validated: " << validated << " / " << sessions.size() << "\n";
+        return 0;
+    }
     // Initialize the network description
     //FullMesh network_description = (g_options.latency == 0.0 && g_options.bytes_per_sec == 0.0)
       //                                 ? FullMesh::new_default()
@@ -96,11 +365,39 @@ int main(int argc, char* argv[]) {
     */
     FullMesh network_description = (g_options.latency < 0.0 || g_options.bytes_per_sec < 0.0)
                                         ? FullMesh::new_default()
-                                        : FullMesh(g_options.latency, g_options.bytes_per_sec, g_options.party_count /*, g_stats*/);
+                                        : FullMesh(g_options.latency, g_options.bytes_per_sec, g_options.party_count, g_stats);
+    try {
+        std::shared_ptr<const SpeedModel> speed_model = SpeedModel::from_options(g_options);
+        if (speed_model) {
+            speed_model->print_summary();
+        }
+        network_description.set_speed_model(speed_model);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
     // Run the protocol
-    ApproximateMpsi protocol(network_description, g_options.bin_count, g_options.hash_count, g_options.hash_function, g_options.domain_size, g_options.set_size /*, g_stats*/);
-    /*Stats stats =*/ 
-    protocol.evaluate("Experiment", g_options.party_count, network_description, g_options.repetitions);
+    ApproximateMpsi protocol(network_description, g_options.bin_count, g_options.hash_count, g_options.hash_function, g_options.domain_size, g_options.set_size, g_options, g_stats);
+    if (g_options.phase == "offline") {
+        /* Input-independent work only; a later --phase online run consumes the files */
+        protocol.precompute_zero_shares(g_options.party_count, g_options.repetitions);
+        return 0;
+    }
+    try {
+        if (g_options.daemon_epochs > 0) {
+            protocol.run_daemon(g_options.party_count, g_options.daemon_epochs);
+            return 0;
+        }
+        /*Stats stats =*/ 
+        protocol.evaluate("Experiment", g_options.party_count, network_description, g_options.repetitions);
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (plan) {
+        print_plan_vs_measured(*plan, g_stats, g_options.party_count, g_options.repetitions);
+    }
 
     // Output results
     //stats.output_party_csv(1); //, g_options.results_filename);
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include "param_planner.hpp"
+#include "Set.hpp"
+#include "secret_sharing_simd.hpp"
+
+size_t align_bin_count(size_t bin_count, const std::string& bloom_layout, size_t block_bins) {
+    /* Bins are rounded to 64 by ApproximateMpsi and must tile whole share chunks (or blocks) */
+    size_t alignment = std::lcm<size_t>(64, bloom_layout == "blocked" ? block_bins : SHARE_BYTE_COUNT);
+    return ((bin_count + alignment - 1) / alignment) * alignment;
+}
+
+static void predict_costs(ParameterPlan& plan, size_t set_size, size_t party_count, size_t seed_count,
+                          bool blocked, const CostModel& costs) {
+    const double ns = 1e-9;
+    const size_t senders = party_count - 1;          // Querier and clients all send a share
+    const size_t hash_calls = blocked ? 1 : plan.hash_count;
+    const size_t cache_misses = blocked ? 1 : plan.hash_count;
+
+    plan.client_bytes = plan.share_width * plan.bin_count;
+    plan.query_bytes = sizeof(size_t) + set_size * (sizeof(size_t) + plan.hash_count * sizeof(size_t));
+    plan.result_bytes = (set_size + 7) / 8;
+    plan.total_bytes = senders * plan.client_bytes + plan.query_bytes + plan.result_bytes;
+
+    plan.client_seconds = ns * (static_cast<double>(seed_count) * plan.client_bytes * costs.xof_ns_per_byte
+                                + static_cast<double>(set_size) * hash_calls * costs.hash_ns);
+    plan.querier_seconds = ns * static_cast<double>(set_size) * hash_calls * costs.hash_ns;
+    plan.server_seconds = ns * (static_cast<double>(senders) * plan.client_bytes * costs.xor_ns_per_byte
+                                + static_cast<double>(set_size) * cache_misses * costs.probe_ns);
+
+    double bandwidth = costs.bytes_per_sec > 0.0 ? costs.bytes_per_sec : costs.default_bytes_per_sec;
+    plan.wire_seconds = plan.total_bytes / bandwidth + (senders + 2) * costs.latency / 1000.0;
+
+    /* Clients run concurrently, the querier and server are on the critical path */
+    plan.objective = plan.client_seconds + plan.querier_seconds + plan.server_seconds + plan.wire_seconds;
+}
+
+ParameterPlan plan_parameters(size_t set_size, size_t party_count, size_t seed_count,
+                              double target_fpr, const std::string& bloom_layout,
+                              size_t block_bins, const CostModel& costs) {
+    const bool blocked = (bloom_layout == "blocked");
+    const size_t n = std::max<size_t>(set_size, 1);
+    const size_t max_hash_count = blocked ? std::min<size_t>(32, block_bins) : 32;
+    ParameterPlan best;
+    best.objective = std::numeric_limits<double>::infinity();
+
+    for (size_t width = 1; width <= SHARE_BYTE_COUNT; width++) {
+        /* A corrupted bin leaves a uniformly random width-byte XOR, zero with probability 2^-8w */
+        double share_fpr = std::ldexp(1.0, -8 * static_cast<int>(width));
+        if (share_fpr >= target_fpr) continue;
+        double bloom_target = target_fpr - share_fpr;
+
+        for (size_t k = 1; k <= max_hash_count; k++) {
+            double bits_per_element = blocked
+                ? Set::blocked_bits_per_element(bloom_target, k, block_bins)
+                : -static_cast<double>(k) / std::log(1.0 - std::pow(bloom_target, 1.0 / k));
+
+            ParameterPlan plan;
+            plan.hash_count = k;
+            plan.share_width = width;
+            plan.bin_count = align_bin_count(static_cast<size_t>(std::ceil(n * bits_per_element)), bloom_layout, block_bins);
+            double actual_bits = static_cast<double>(plan.bin_count) / n;
+            plan.bloom_fpr = blocked ? Set::blocked_false_positive_rate(actual_bits, k, block_bins)
+                                     : Set::standard_false_positive_rate(actual_bits, k);
+            plan.share_fpr = share_fpr;
+            predict_costs(plan, n, party_count, seed_count, blocked, costs);
+
+            if (plan.objective < best.objective) {
+                best = plan;
+            }
+        }
+    }
+
+    if (best.bin_count == 0) {
+        throw std::invalid_argument("plan_parameters: target false positive probability is unreachable");
+    }
+    return best;
+}
+
+void print_plan(const ParameterPlan& plan) {
+    std::cout << "Parameter Plan:\n"
+              << "  Bin Count: " << plan.bin_count << "\n"
+              << "  Hash Count: " << plan.hash_count << "\n"
+              << "  Share Width (bytes/bin): " << plan.share_width << "\n"
+              << "  Bloom FPR: " << plan.bloom_fpr << ", Share FPR: " << plan.share_fpr
+              << ", Total FPR: " << plan.bloom_fpr + plan.share_fpr << "\n"
+              << "  Predicted Client (s): " << plan.client_seconds << "\n"
+              << "  Predicted Querier (s): " << plan.querier_seconds << "\n"
+              << "  Predicted Server (s): " << plan.server_seconds << "\n"
+              << "  Predicted Wire (s): " << plan.wire_seconds << "\n"
+              << "  Client Share (bytes): " << plan.client_bytes << "\n"
+              << "  Query (bytes): " << plan.query_bytes << ", Result (bytes): " << plan.result_bytes << "\n"
+              << "  Total Communication (bytes): " << plan.total_bytes << "\n";
+}
+
+void print_plan_vs_measured(const ParameterPlan& plan, const Stats& stats, size_t party_count, size_t repetitions) {
+    if (!g_options.stats) {
+        std::cout << "Planner: run with --stats 1 to compare predicted and measured costs\n";
+        return;
+    }
+    const size_t clients = party_count > 2 ? party_count - 2 : 1;
+    const double reps = static_cast<double>(std::max<size_t>(repetitions, 1));
+    auto measured_s = [&](int party) { return stats.get_compute_breakdown(party) / reps / 1000.0; };
+
+    std::cout << "Planner: predicted vs measured (per repetition)\n"
+              << "  Server (s): " << plan.server_seconds << " vs " << measured_s(0) << "\n"
+              << "  Querier (s): " << plan.client_seconds + plan.querier_seconds << " vs " << measured_s(1) << "\n"
+              << "  Client (s): " << plan.client_seconds << " vs " << measured_s(2) / clients << "\n"
+              << "  Client Share (bytes): " << plan.client_bytes << " vs "
+              << stats.get_msg_complexity(2).msg_size / reps / clients << "\n"
+              << "  Querier Sent (bytes): " << plan.client_bytes + plan.query_bytes << " vs "
+              << stats.get_msg_complexity(1).msg_size / reps << "\n";
+}
@@ -0,0 +1,48 @@
+#ifndef PARAM_PLANNER_HPP
+#define PARAM_PLANNER_HPP
+
+#include <cstddef>
+#include <string>
+#include "Stats.hpp"
+
+// Per-operation costs used to predict runtime; defaults are rough single-core figures
+struct CostModel {
+    double hash_ns = 300.0;             // One element hash on the client/querier
+    double xof_ns_per_byte = 1.0;       // Zero-share expansion, per seed and output byte
+    double probe_ns = 80.0;             // One random access into the server's share
+    double xor_ns_per_byte = 0.25;      // Server-side share aggregation
+    double bytes_per_sec = 0.0;         // Link bandwidth (0 = use default_bytes_per_sec)
+    double latency = 0.0;               // Per-message latency in ms (as FullMesh applies it)
+    double default_bytes_per_sec = 125'000'000.0; // 1 Gbit/s when no bandwidth is simulated
+};
+
+// Output of the planner: protocol parameters plus predicted costs
+struct ParameterPlan {
+    size_t bin_count = 0;       // Bloom filter bins (one bit each)
+    size_t hash_count = 0;
+    size_t share_width = 0;     // Share bytes per bin
+    double bloom_fpr = 0.0;     // False positives from the bloom filter
+    double share_fpr = 0.0;     // False zero-tests from a share_width-byte XOR
+    double client_seconds = 0.0;    // Per client
+    double querier_seconds = 0.0;   // Query generation (client part excluded)
+    double server_seconds = 0.0;
+    double wire_seconds = 0.0;
+    size_t client_bytes = 0;    // Share size sent by each client
+    size_t query_bytes = 0;
+    size_t result_bytes = 0;
+    size_t total_bytes = 0;
+    double objective = 0.0;     // Runtime + time on the wire for total_bytes
+};
+
+// Round a bin count so the filter tiles whole share chunks (or blocks) and 64-bin words
+size_t align_bin_count(size_t bin_count, const std::string& bloom_layout, size_t block_bins);
+
+// Derive bin_count, hash_count and share_width for a target false-positive probability
+ParameterPlan plan_parameters(size_t set_size, size_t party_count, size_t seed_count,
+                              double target_fpr, const std::string& bloom_layout,
+                              size_t block_bins, const CostModel& costs);
+
+void print_plan(const ParameterPlan& plan);
+void print_plan_vs_measured(const ParameterPlan& plan, const Stats& stats, size_t party_count, size_t repetitions);
+
+#endif // PARAM_PLANNER_HPP
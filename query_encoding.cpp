@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "query_encoding.hpp"
+
+static constexpr size_t DIGEST_BYTES = sizeof(std::array<uint64_t, 2>);
+
+std::vector<uint8_t> encode_query_digests(const std::vector<std::array<uint64_t, 2>>& digests) {
+    uint64_t count = digests.size();
+    std::vector<uint8_t> message(sizeof(count) + count * DIGEST_BYTES);
+    std::memcpy(message.data(), &count, sizeof(count));
+    std::memcpy(message.data() + sizeof(count), digests.data(), count * DIGEST_BYTES);
+    return message;
+}
+
+std::vector<std::array<uint64_t, 2>> decode_query_digests(const std::vector<uint8_t>& message) {
+    uint64_t count = 0;
+    if (message.size() < sizeof(count)) {
+        throw std::runtime_error("decode_query_digests: truncated header");
+    }
+    std::memcpy(&count, message.data(), sizeof(count));
+    if (message.size() != sizeof(count) + count * DIGEST_BYTES) {
+        throw std::runtime_error("decode_query_digests: size mismatch");
+    }
+    std::vector<std::array<uint64_t, 2>> digests(count);
+    std::memcpy(digests.data(), message.data() + sizeof(count), count * DIGEST_BYTES);
+    return digests;
+}
+
+size_t index_bit_width(size_t max_value) {
+    size_t bits = 1;
+    while (bits < 64 && (max_value >> bits) != 0) {
+        ++bits;
+    }
+    return bits;
+}
+
+std::vector<uint8_t> encode_packed_query(const std::vector<std::vector<size_t>>& patterns) {
+    uint64_t header[3] = {patterns.size(), patterns.empty() ? 0 : patterns[0].size(), 0};
+    size_t max_index = 0;
+    for (const auto& pattern : patterns) {
+        if (pattern.size() != header[1]) {
+            throw std::invalid_argument("encode_packed_query: patterns of different lengths (" +
+                                        std::to_string(pattern.size()) + " vs " + std::to_string(header[1]) + ")");
+        }
+        for (size_t index : pattern) {
+            max_index = std::max(max_index, index);
+        }
+    }
+    const size_t bits = index_bit_width(max_index);
+    header[2] = bits;
+
+    /* Bits are appended LSB first through a 64-bit accumulator; the +8 slack lets the
+       flush write a whole word */
+    const size_t payload_bytes = (header[0] * header[1] * bits + 7) / 8;
+    std::vector<uint8_t> message(sizeof(header) + payload_bytes + sizeof(uint64_t));
+    std::memcpy(message.data(), header, sizeof(header));
+    uint8_t* out = message.data() + sizeof(header);
+    unsigned __int128 acc = 0;
+    size_t acc_bits = 0;
+    for (const auto& pattern : patterns) {
+        for (size_t index : pattern) {
+            acc |= static_cast<unsigned __int128>(index) << acc_bits;
+            acc_bits += bits;
+            if (acc_bits >= 64) {
+                uint64_t word = static_cast<uint64_t>(acc);
+                std::memcpy(out, &word, sizeof(word));
+                out += sizeof(word);
+                acc >>= 64;
+                acc_bits -= 64;
+            }
+        }
+    }
+    uint64_t word = static_cast<uint64_t>(acc);
+    std::memcpy(out, &word, sizeof(word));
+    message.resize(sizeof(header) + payload_bytes);
+    return message;
+}
+
+std::vector<std::vector<size_t>> decode_packed_query(const std::vector<uint8_t>& message) {
+    uint64_t header[3];
+    if (message.size() < sizeof(header)) {
+        throw std::runtime_error("decode_packed_query: truncated header");
+    }
+    std::memcpy(header, message.data(), sizeof(header));
+    const size_t count = header[0], length = header[1], bits = header[2];
+    if (bits == 0 || bits > 64 || message.size() != sizeof(header) + (count * length * bits + 7) / 8) {
+        throw std::runtime_error("decode_packed_query: size mismatch");
+    }
+
+    const uint8_t* in = message.data() + sizeof(header);
+    const uint8_t* end = message.data() + message.size();
+    const uint64_t mask = bits == 64 ? ~0ULL : (1ULL << bits) - 1;
+    unsigned __int128 acc = 0;
+    size_t acc_bits = 0;
+    std::vector<std::vector<size_t>> patterns(count, std::vector<size_t>(length));
+    for (auto& pattern : patterns) {
+        for (size_t& index : pattern) {
+            if (acc_bits < bits) {
+                uint64_t word = 0;
+                std::memcpy(&word, in, std::min<size_t>(sizeof(word), end - in));
+                in += std::min<size_t>(sizeof(word), end - in);
+                acc |= static_cast<unsigned __int128>(word) << acc_bits;
+                acc_bits += 64;
+            }
+            index = static_cast<size_t>(acc & mask);
+            acc >>= bits;
+            acc_bits -= bits;
+        }
+    }
+    return patterns;
+}
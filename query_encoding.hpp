@@ -0,0 +1,25 @@
+#ifndef QUERY_ENCODING_HPP
+#define QUERY_ENCODING_HPP
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// Compact wire formats for the querier's patterns (instead of 8 bytes per index):
+//  - digests: one 16-byte element digest per element; the server recomputes the indices
+//    (only where the indices are a function of the digest: blocked layout, fuse encoding).
+//    Header: uint64 count.
+//  - packed indices: every index in the minimal bit width for the largest one, patterns of
+//    equal length back to back. Header: uint64 pattern count, pattern length, bit width.
+
+std::vector<uint8_t> encode_query_digests(const std::vector<std::array<uint64_t, 2>>& digests);
+std::vector<std::array<uint64_t, 2>> decode_query_digests(const std::vector<uint8_t>& message);
+
+std::vector<uint8_t> encode_packed_query(const std::vector<std::vector<size_t>>& patterns);
+std::vector<std::vector<size_t>> decode_packed_query(const std::vector<uint8_t>& message);
+
+// Bits needed to store every value in [0, max_value]
+size_t index_bit_width(size_t max_value);
+
+#endif // QUERY_ENCODING_HPP
@@ -13,6 +13,7 @@
 #include "secret_sharing_simd.hpp"
 #include "hash_funcs.hpp"
 #include "ThreadPool.h"
+#include "TaskRuntime.hpp"
 
 // Constants
 //constexpr size_t SHARE_BYTE_COUNT = 64;
@@ -202,7 +203,10 @@ SimdBytes blake3_xof(const std::array<uint8_t, RAND_SECRET_SIZE>& seed, size_t b
 SimdBytes do_generic_hash(const std::array<uint8_t, RAND_SECRET_SIZE>& seed, size_t byte_count, std::string hash_func) {
 
     //auto expanded_bytes = generic_hash_func(hash_func, seed.data(), seed.size());
-    auto expanded_bytes = generic_hash_func(hash_func, seed.data(), byte_count);
+    /* The hash reads (and outputs) byte_count bytes, so pad the seed with zeros to that length */
+    std::vector<uint8_t> padded_seed(std::max(byte_count, seed.size()), 0);
+    std::copy(seed.begin(), seed.end(), padded_seed.begin());
+    auto expanded_bytes = generic_hash_func(hash_func, padded_seed.data(), byte_count);
     return SimdBytes::from_bytes(expanded_bytes);
 }
 
@@ -314,7 +318,7 @@ SimdBytes create_zero_share_parallel(
     result.resize(byte_count);  // XOR result should match byte_count
     std::vector<std::future<SimdBytes>> futures;
 
-    ThreadPool pool(std::thread::hardware_concurrency());
+    ThreadPool& pool = compute_pool();
 
     for (size_t i = 0; i < seed_count; ++i) {
         futures.emplace_back(
@@ -423,7 +427,17 @@ SimdBytes conditionally_corrupt_share_parallel(
     const std::vector<bool>& conditions,
     size_t chunk_size  // Usually SHARE_BYTE_COUNT
 ) {
-    const size_t total_size = share.bytes.size();
+    return conditionally_corrupt_share_parallel(share.bytes.data(), share.bytes.size(), conditions, chunk_size);
+}
+
+/* Pointer variant: the zero share may live in a memory-mapped file */
+SimdBytes conditionally_corrupt_share_parallel(
+    const uint8_t* share,
+    size_t share_size,
+    const std::vector<bool>& conditions,
+    size_t chunk_size  // Usually SHARE_BYTE_COUNT
+) {
+    const size_t total_size = share_size;
     const size_t num_chunks = conditions.size();
     //assert(total_size >= chunk_size * num_chunks);//Wronly put assertion
 
@@ -451,7 +465,7 @@ SimdBytes conditionally_corrupt_share_parallel(
             } else {
                 segment[i - start] = random_bytes[i];
             }
-            segment[i - start] ^= share.bytes[i%total_size];
+            segment[i - start] ^= share[i%total_size];
         }
 
         return segment;
@@ -466,7 +480,7 @@ SimdBytes conditionally_corrupt_share_parallel(
         size_t start = t * chunk;
         size_t end = std::min(start + chunk, num_chunks); //total_size);
         if (start >= end) break;  // Avoid launching empty tasks
-        futures.emplace_back(std::async(std::launch::async, corrupt_worker, start, end));
+        futures.emplace_back(compute_pool().enqueue(corrupt_worker, start, end));
     }
 
     // Step 4: Combine all results
@@ -479,4 +493,99 @@ SimdBytes conditionally_corrupt_share_parallel(
     }
 
     return corrupted;
-}
\ No newline at end of file
+}
+
+void xor_bytes(uint8_t* dst, const uint8_t* src, size_t n) {
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i + 16));
+        __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i + 32));
+        __m128i a3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i + 48));
+        a0 = _mm_xor_si128(a0, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+        a1 = _mm_xor_si128(a1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16)));
+        a2 = _mm_xor_si128(a2, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 32)));
+        a3 = _mm_xor_si128(a3, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 48)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), a0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 16), a1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 32), a2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 48), a3);
+    }
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        a = _mm_xor_si128(a, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), a);
+    }
+    for (; i < n; ++i) {
+        dst[i] ^= src[i];
+    }
+}
+
+/* Corrupt bins [first_bin, first_bin + bin_count) into 'out' (bin_count * width bytes).
+   Zero-share bytes wrap around when the share is shorter than the filter (legacy layout). */
+void corrupt_share_range(
+    const uint8_t* share,
+    size_t share_size,
+    const std::vector<bool>& conditions,
+    size_t first_bin,
+    size_t bin_count,
+    size_t width,
+    uint8_t* out,
+    std::random_device& rd
+) {
+    const bool wraps = (first_bin + bin_count) * width > share_size;
+    for (size_t c = first_bin; c < first_bin + bin_count; ++c) {
+        uint8_t* dst = out + (c - first_bin) * width;
+        for (size_t i = 0; i < width; i += sizeof(uint32_t)) {
+            uint32_t r = conditions[c] ? 0 : rd();
+            for (size_t j = 0; j < sizeof(uint32_t) && i + j < width; ++j) {
+                size_t pos = c * width + i + j;
+                dst[i + j] = share[wraps ? pos % share_size : pos] ^ static_cast<uint8_t>(r >> (8 * j));
+            }
+        }
+    }
+}
+
+/* Bin-aligned variant: share holds 'chunk_size' bytes per condition (bin). Bins whose
+   condition is set keep the zero share, all other bins are masked with fresh randomness. */
+SimdBytes conditionally_corrupt_share_chunked_parallel(
+    const SimdBytes& share,
+    const std::vector<bool>& conditions,
+    size_t chunk_size
+) {
+    return conditionally_corrupt_share_chunked_parallel(share.bytes.data(), share.bytes.size(), conditions, chunk_size);
+}
+
+SimdBytes conditionally_corrupt_share_chunked_parallel(
+    const uint8_t* share,
+    size_t share_size,
+    const std::vector<bool>& conditions,
+    size_t chunk_size
+) {
+    const size_t num_chunks = conditions.size();
+    assert(share_size >= num_chunks * chunk_size && "Share too small for the condition mask");
+
+    SimdBytes corrupted(num_chunks * chunk_size);
+
+    auto corrupt_worker = [&](size_t start, size_t end) {
+        std::random_device rd;
+        corrupt_share_range(share, share_size, conditions, start, end - start, chunk_size,
+                            corrupted.bytes.data() + start * chunk_size, rd);
+    };
+
+    const size_t num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    const size_t per_thread = (num_chunks + num_threads - 1) / num_threads;
+
+    std::vector<std::future<void>> futures;
+    for (size_t t = 0; t < num_threads; ++t) {
+        size_t start = t * per_thread;
+        size_t end = std::min(start + per_thread, num_chunks);
+        if (start >= end) break;
+        futures.emplace_back(compute_pool().enqueue(corrupt_worker, start, end));
+    }
+    for (auto& fut : futures) {
+        fut.get();
+    }
+
+    return corrupted;
+}
@@ -7,6 +7,8 @@
 #include <array>
 #include <cstdint>
 #include <algorithm>
+#include <cassert>
+#include <random>
 
 // Constants
 constexpr size_t SHARE_BYTE_COUNT = 40; // 64;
@@ -156,4 +158,40 @@ SimdBytes conditionally_corrupt_share_parallel(
     const std::vector<bool>& conditions,
     size_t chunk_size=SHARE_BYTE_COUNT  // Usually SHARE_BYTE_COUNT
 );
+
+SimdBytes conditionally_corrupt_share_chunked_parallel(
+    const SimdBytes& share,
+    const std::vector<bool>& conditions,
+    size_t chunk_size  // Share width in bytes per bin
+);
+
+/* Same as above, reading the zero share through a pointer (e.g. a mapped file) */
+SimdBytes conditionally_corrupt_share_parallel(
+    const uint8_t* share,
+    size_t share_size,
+    const std::vector<bool>& conditions,
+    size_t chunk_size=SHARE_BYTE_COUNT
+);
+
+SimdBytes conditionally_corrupt_share_chunked_parallel(
+    const uint8_t* share,
+    size_t share_size,
+    const std::vector<bool>& conditions,
+    size_t chunk_size
+);
+
+/* dst[i] ^= src[i] for n bytes, 64 bytes per step with SSE2 */
+void xor_bytes(uint8_t* dst, const uint8_t* src, size_t n);
+
+/* Serial kernel behind the chunked variant; corrupts one bin range into 'out' */
+void corrupt_share_range(
+    const uint8_t* share,
+    size_t share_size,
+    const std::vector<bool>& conditions,
+    size_t first_bin,
+    size_t bin_count,
+    size_t width,
+    uint8_t* out,
+    std::random_device& rd
+);
 #endif // SECRET_SHARING_SIMD_HPP
\ No newline at end of file
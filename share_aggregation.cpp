@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <future>
+#include <thread>
+#include "share_aggregation.hpp"
+#include "secret_sharing_simd.hpp"
+
+/* Ranges below this size are not worth a task; blocks keep the accumulator in L1 */
+static constexpr size_t MIN_RANGE_BYTES = 64 * 1024;
+static constexpr size_t FOLD_BLOCK_BYTES = 16 * 1024;
+
+/* Method Definitions for 'AggregationEngine' class */
+AggregationEngine::AggregationEngine(size_t thread_count)
+    : threads(thread_count == 0 ? std::max<size_t>(1, std::thread::hardware_concurrency()) : thread_count) {
+    if (threads > 1) {
+        pool = std::make_unique<ThreadPool>(threads);
+    }
+}
+
+size_t AggregationEngine::thread_count() const {
+    return threads;
+}
+
+void AggregationEngine::fold_range(uint8_t* accumulator, const std::vector<const uint8_t*>& sources,
+                                   size_t begin, size_t end) const {
+    for (size_t block = begin; block < end; block += FOLD_BLOCK_BYTES) {
+        size_t length = std::min(FOLD_BLOCK_BYTES, end - block);
+        for (const uint8_t* source : sources) {
+            xor_bytes(accumulator + block, source + block, length);
+        }
+    }
+}
+
+void AggregationEngine::fold(uint8_t* accumulator, const std::vector<const uint8_t*>& sources, size_t length) {
+    size_t ranges = std::min(threads, std::max<size_t>(1, length / MIN_RANGE_BYTES));
+    if (ranges <= 1) {
+        fold_range(accumulator, sources, 0, length);
+        return;
+    }
+
+    /* Range boundaries on 64-byte lines so no two workers write the same cache line */
+    size_t per_range = ((length + ranges - 1) / ranges + 63) & ~static_cast<size_t>(63);
+    std::vector<std::future<void>> futures;
+    for (size_t begin = 0; begin < length; begin += per_range) {
+        size_t end = std::min(begin + per_range, length);
+        futures.push_back(pool->enqueue([this, accumulator, &sources, begin, end]() {
+            fold_range(accumulator, sources, begin, end);
+        }));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+}
+
+void AggregationEngine::tree_reduce(const std::vector<uint8_t*>& shares, size_t length) {
+    for (size_t stride = 1; stride < shares.size(); stride *= 2) {
+        std::vector<std::future<void>> futures;
+        for (size_t i = 0; i + stride < shares.size(); i += 2 * stride) {
+            uint8_t* dst = shares[i];
+            const uint8_t* src = shares[i + stride];
+            if (pool) {
+                futures.push_back(pool->enqueue([dst, src, length]() { xor_bytes(dst, src, length); }));
+            } else {
+                xor_bytes(dst, src, length);
+            }
+        }
+        for (auto& future : futures) {
+            future.get();
+        }
+    }
+}
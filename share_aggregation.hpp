@@ -0,0 +1,31 @@
+#ifndef SHARE_AGGREGATION_HPP
+#define SHARE_AGGREGATION_HPP
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "ThreadPool.h"
+
+// Parallel XOR aggregation of client shares on the server.
+//  - fold(): the share is split into bin ranges, one per worker; each worker XORs every
+//    source over its range, so the accumulator range stays in cache across sources.
+//  - tree_reduce(): pairwise XOR rounds over a burst of shares (log2(n) rounds, the pairs
+//    of a round run in parallel). Shares are updated in place; the result is in shares[0].
+class AggregationEngine {
+public:
+    explicit AggregationEngine(size_t thread_count); // 0 = hardware concurrency
+
+    void fold(uint8_t* accumulator, const std::vector<const uint8_t*>& sources, size_t length);
+    void tree_reduce(const std::vector<uint8_t*>& shares, size_t length);
+
+    size_t thread_count() const;
+
+private:
+    size_t threads;
+    std::unique_ptr<ThreadPool> pool; // Only when threads > 1
+
+    void fold_range(uint8_t* accumulator, const std::vector<const uint8_t*>& sources, size_t begin, size_t end) const;
+};
+
+#endif // SHARE_AGGREGATION_HPP
@@ -0,0 +1,127 @@
+#include <cstring>
+#include <map>
+#include <utility>
+#include <stdexcept>
+#include <string>
+#include "share_stream.hpp"
+
+std::vector<uint8_t> encode_share_chunk(uint64_t offset, uint64_t total, const uint8_t* payload, size_t length) {
+    std::vector<uint8_t> message(SHARE_CHUNK_HEADER_BYTES + length);
+    std::memcpy(message.data(), &offset, sizeof(offset));
+    std::memcpy(message.data() + sizeof(offset), &total, sizeof(total));
+    std::memcpy(message.data() + SHARE_CHUNK_HEADER_BYTES, payload, length);
+    return message;
+}
+
+ShareChunk decode_share_chunk(const std::vector<uint8_t>& message) {
+    if (message.size() < SHARE_CHUNK_HEADER_BYTES) {
+        throw std::runtime_error("decode_share_chunk: truncated header");
+    }
+    ShareChunk chunk;
+    std::memcpy(&chunk.offset, message.data(), sizeof(chunk.offset));
+    std::memcpy(&chunk.total, message.data() + sizeof(chunk.offset), sizeof(chunk.total));
+    chunk.payload = message.data() + SHARE_CHUNK_HEADER_BYTES;
+    chunk.length = message.size() - SHARE_CHUNK_HEADER_BYTES;
+    if (chunk.offset + chunk.length > chunk.total) {
+        throw std::runtime_error("decode_share_chunk: chunk past the end of the share");
+    }
+    return chunk;
+}
+
+ShareChunk whole_share_chunk(const std::vector<uint8_t>& share) {
+    ShareChunk chunk;
+    chunk.total = share.size();
+    chunk.payload = share.data();
+    chunk.length = share.size();
+    return chunk;
+}
+
+/* Method Definitions for 'ShareStreamAggregator' class */
+ShareStreamAggregator::ShareStreamAggregator(size_t sender_count, AggregationEngine* engine)
+    : engine(engine), received(sender_count, 0), expected(sender_count, 0), started(sender_count, false) {}
+
+bool ShareStreamAggregator::accept(size_t sender_index, const ShareChunk& chunk) {
+    if (!started[sender_index]) {
+        started[sender_index] = true;
+        expected[sender_index] = chunk.total;
+    }
+    if (chunk.total == 0) {
+        return false;  // Empty share: nothing to fold
+    }
+    if (aggregated.size() == 0) {
+        aggregated = SimdBytes(chunk.total);
+    }
+    if (chunk.total != aggregated.size() || chunk.total != expected[sender_index]) {
+        throw std::runtime_error("ShareStreamAggregator: sender " + std::to_string(sender_index) +
+                                 " streams a share of " + std::to_string(chunk.total) + " bytes, expected " +
+                                 std::to_string(aggregated.size()));
+    }
+    received[sender_index] += chunk.length;
+    return chunk.length > 0;
+}
+
+void ShareStreamAggregator::add(size_t sender_index, const ShareChunk& chunk) {
+    if (!accept(sender_index, chunk)) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    xor_bytes(aggregated.bytes.data() + chunk.offset, chunk.payload, chunk.length);
+    folding += std::chrono::steady_clock::now() - start;
+}
+
+void ShareStreamAggregator::add_batch(const std::vector<size_t>& sender_indices,
+                                      std::vector<std::vector<uint8_t>>& messages, bool chunked, bool tree) {
+    /* Group payloads by the byte range they cover; whole shares all land in one group */
+    std::map<std::pair<uint64_t, size_t>, std::vector<uint8_t*>> ranges;
+    for (size_t m = 0; m < messages.size(); ++m) {
+        ShareChunk chunk = chunked ? decode_share_chunk(messages[m]) : whole_share_chunk(messages[m]);
+        if (accept(sender_indices[m], chunk)) {
+            size_t header = chunked ? SHARE_CHUNK_HEADER_BYTES : 0;
+            ranges[{chunk.offset, chunk.length}].push_back(messages[m].data() + header);
+        }
+    }
+
+    for (auto& [range, payloads] : ranges) {
+        uint8_t* dst = aggregated.bytes.data() + range.first;
+        if (engine == nullptr) {
+            auto start = std::chrono::steady_clock::now();
+            for (const uint8_t* payload : payloads) {
+                xor_bytes(dst, payload, range.second);
+            }
+            folding += std::chrono::steady_clock::now() - start;
+            continue;
+        }
+        if (tree && payloads.size() > 1) {
+            auto start = std::chrono::steady_clock::now();
+            engine->tree_reduce(payloads, range.second);
+            payloads.resize(1);
+            reducing += std::chrono::steady_clock::now() - start;
+        }
+        auto start = std::chrono::steady_clock::now();
+        engine->fold(dst, std::vector<const uint8_t*>(payloads.begin(), payloads.end()), range.second);
+        folding += std::chrono::steady_clock::now() - start;
+    }
+}
+
+bool ShareStreamAggregator::complete(size_t sender_index) const {
+    return started[sender_index] && received[sender_index] >= expected[sender_index];
+}
+
+bool ShareStreamAggregator::all_complete() const {
+    for (size_t i = 0; i < received.size(); ++i) {
+        if (!complete(i)) return false;
+    }
+    return true;
+}
+
+SimdBytes& ShareStreamAggregator::aggregate() {
+    return aggregated;
+}
+
+std::chrono::steady_clock::duration ShareStreamAggregator::fold_time() const {
+    return folding;
+}
+
+std::chrono::steady_clock::duration ShareStreamAggregator::tree_time() const {
+    return reducing;
+}
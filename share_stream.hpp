@@ -0,0 +1,63 @@
+#ifndef SHARE_STREAM_HPP
+#define SHARE_STREAM_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include "secret_sharing_simd.hpp"
+#include "share_aggregation.hpp"
+
+// One piece of a streamed share: 'length' bytes at byte 'offset' of a 'total'-byte share.
+// On the wire: uint64 offset, uint64 total, then the payload.
+struct ShareChunk {
+    uint64_t offset = 0;
+    uint64_t total = 0;
+    const uint8_t* payload = nullptr;
+    size_t length = 0;
+};
+
+constexpr size_t SHARE_CHUNK_HEADER_BYTES = 2 * sizeof(uint64_t);
+
+std::vector<uint8_t> encode_share_chunk(uint64_t offset, uint64_t total, const uint8_t* payload, size_t length);
+// The returned chunk points into 'message'
+ShareChunk decode_share_chunk(const std::vector<uint8_t>& message);
+// A share sent in one piece, viewed as a single chunk (points into 'share')
+ShareChunk whole_share_chunk(const std::vector<uint8_t>& share);
+
+// Server side: XOR chunks (or whole shares) into a running aggregate as they arrive, in any
+// order and interleaved across senders. A sender is complete once 'total' bytes have arrived.
+// With an engine, add_batch() folds a burst of messages in parallel: messages covering the
+// same byte range are folded together (or tree-reduced first), one bin range per thread.
+class ShareStreamAggregator {
+public:
+    explicit ShareStreamAggregator(size_t sender_count, AggregationEngine* engine = nullptr);
+
+    void add(size_t sender_index, const ShareChunk& chunk);
+    // Messages are encoded chunks when 'chunked', whole shares otherwise; tree reduction
+    // XORs them into each other in place
+    void add_batch(const std::vector<size_t>& sender_indices, std::vector<std::vector<uint8_t>>& messages,
+                   bool chunked, bool tree);
+    bool complete(size_t sender_index) const;
+    bool all_complete() const;
+
+    SimdBytes& aggregate();
+
+    // Time spent in each aggregation phase so far
+    std::chrono::steady_clock::duration fold_time() const;
+    std::chrono::steady_clock::duration tree_time() const;
+
+private:
+    AggregationEngine* engine;
+    SimdBytes aggregated;
+    std::vector<size_t> received;  // Payload bytes per sender
+    std::vector<size_t> expected;  // Share size per sender, known from its first chunk
+    std::vector<bool> started;
+    std::chrono::steady_clock::duration folding{0};
+    std::chrono::steady_clock::duration reducing{0};
+
+    // Bookkeeping for one chunk; false when there is nothing to fold
+    bool accept(size_t sender_index, const ShareChunk& chunk);
+};
+
+#endif // SHARE_STREAM_HPP
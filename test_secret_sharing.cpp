@@ -2,19 +2,33 @@
 #include <vector>
 #include <array>
 #include <algorithm>
+#include <random>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
 #include "secret_sharing_simd.hpp" // Include your SSE implementation here
+#include "delta_share.hpp"
+#include "CorrelatedSeeds.hpp"
+#include "query_encoding.hpp"
+#include "BinaryFuseFilter.hpp"
+#include "ShardLayout.hpp"
+#include "ShareEpochServer.hpp"
+#include "ByteStringArena.hpp"
+#include "common.hpp"
+
+Options &g_options = *(new Options());
 
 TEST(SecretSharingTest, TestSecretShares) {
     // Create zero shares
-    SimdBytes share_1 = create_zero_share({{1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1}, 
+    SimdBytes share_1 = create_zero_share_no_resize({{1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1}, 
                                            {2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2}}, 
-                                           128);
-    SimdBytes share_2 = create_zero_share({{1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1}, 
+                                           128, "blake3_xof");
+    SimdBytes share_2 = create_zero_share_no_resize({{1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1}, 
                                            {3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3}}, 
-                                           128);
-    SimdBytes share_3 = create_zero_share({{2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2}, 
+                                           128, "blake3_xof");
+    SimdBytes share_3 = create_zero_share_no_resize({{2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2}, 
                                            {3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3}}, 
-                                           128);
+                                           128, "blake3_xof");
 
     // Assertions for zero shares
     std::vector<uint8_t> zero_bytes(128, 0);
@@ -46,7 +60,7 @@ TEST(SecretSharingTest, TestCorruptShares) {
     conditions[31] = true;
 
     // Corrupt the share based on conditions
-    SimdBytes corrupted = conditionally_corrupt_share(share, conditions);
+    SimdBytes corrupted = conditionally_corrupt_share(share, conditions, 5);
 
     // Assertions for corruption
     auto share_bytes = share.to_bytes();
@@ -71,6 +85,315 @@ TEST(SecretSharingTest, TestCorruptShares) {
               std::vector<uint8_t>(corrupted_bytes.begin() + 35, corrupted_bytes.begin() + 40));
 }
 
+TEST(DeltaShareTest, UpdatedShareMatchesUpdatedSet) {
+    g_options.bloom_layout = "standard";
+    g_options.share_width = 4;
+    const size_t width = 4, bin_count = 2048, hash_count = 5;
+    const std::string hash_func = "blake3_xof";
+
+    Set input;
+    for (size_t element = 0; element < 200; ++element) {
+        input.insert(element * 7 + 3);
+    }
+    std::vector<bool> filter = input.to_bloom_filter(bin_count, hash_count, hash_func);
+    std::vector<uint8_t> zero_bytes(filter.size() * width);
+    for (size_t i = 0; i < zero_bytes.size(); ++i) {
+        zero_bytes[i] = static_cast<uint8_t>(i * 131 + 17);
+    }
+    SimdBytes zero_share = SimdBytes::from_bytes(zero_bytes);
+    SimdBytes sent = conditionally_corrupt_share_chunked_parallel(zero_share, filter, width);
+
+    // The server patches what it holds with the serialized delta
+    DeltaShareClient client(input, filter, width, hash_count, hash_func, zero_share, sent);
+    std::vector<size_t> removed = {3, 10, 17, 24, 31};
+    std::vector<size_t> added = {5000, 5001, 5002, 5003, 5004};
+    ShareDelta delta = client.update(added, removed);
+    SimdBytes held = sent;
+    apply_share_delta(held, ShareDelta::deserialize(delta.serialize()));
+
+    Set expected = input;
+    for (size_t element : removed) expected.erase(element);
+    for (size_t element : added) expected.insert(element);
+    ASSERT_EQ(client.elements().to_vector().size(), expected.to_vector().size());
+    for (size_t element : expected.to_vector()) {
+        ASSERT_TRUE(client.elements().contains(element));
+    }
+
+    // Set bins hold the zero share again, every other bin stays masked
+    std::vector<bool> updated = expected.to_bloom_filter(bin_count, hash_count, hash_func);
+    ASSERT_EQ(updated.size(), filter.size());
+    for (size_t bin = 0; bin < updated.size(); ++bin) {
+        bool zero = std::equal(held.bytes.begin() + bin * width, held.bytes.begin() + (bin + 1) * width,
+                               zero_bytes.begin() + bin * width);
+        ASSERT_EQ(zero, static_cast<bool>(updated[bin])) << "bin " << bin;
+    }
+
+    // Every unchanged element still tests as a member
+    for (size_t element : expected.to_vector()) {
+        for (size_t bin : expected.bloom_filter_indices(element, updated.size(), hash_count, hash_func)) {
+            ASSERT_TRUE(std::equal(held.bytes.begin() + bin * width, held.bytes.begin() + (bin + 1) * width,
+                                   zero_bytes.begin() + bin * width));
+        }
+    }
+}
+
+TEST(DeltaShareTest, CountingFilterFollowsSentFilter) {
+    CountingBloomFilter counting(8);
+    std::vector<size_t> flipped;
+    counting.add({1, 2}, flipped);
+    std::vector<bool> sent = {false, true, false, true, false, false, false, false};
+    ASSERT_EQ(counting.match(sent), 2u);
+    for (size_t bin = 0; bin < sent.size(); ++bin) {
+        ASSERT_EQ(counting.test(bin), static_cast<bool>(sent[bin]));
+    }
+    // A pinned bin stays set when elements are removed
+    flipped.clear();
+    counting.remove({3}, flipped);
+    ASSERT_TRUE(counting.test(3));
+    ASSERT_TRUE(flipped.empty());
+}
+
+TEST(CorrelatedSeedsTest, ExpandCancelsAcrossContributors) {
+    // Odd counts leave one contributor out of each round
+    const size_t byte_count = 96;
+    std::vector<uint8_t> zero_bytes(byte_count, 0);
+    for (size_t count : {2, 3, 4, 5, 8}) {
+        auto keys = CorrelatedSeeds::deal_pair_keys(1, count);
+        SimdBytes aggregated(byte_count, 0);
+        for (size_t party = 1; party <= count; ++party) {
+            // Each party holds only the keys of its own pairs
+            ASSERT_EQ(keys[party - 1].size(), count - 1);
+            ASSERT_EQ(keys[party - 1].count(party), 0u);
+            SimdBytes share = CorrelatedSeeds(keys[party - 1], party, 1, count, 12).expand(byte_count);
+            ASSERT_NE(share.to_bytes(), zero_bytes) << "count " << count << ", party " << party;
+            aggregated ^= share;
+        }
+        ASSERT_EQ(aggregated.to_bytes(), zero_bytes) << "count " << count;
+    }
+}
+
+TEST(CorrelatedSeedsTest, PairCorrectionsCancelExcludedPairs) {
+    const size_t byte_count = 96, seed_count = 12;
+    std::vector<uint8_t> zero_bytes(byte_count, 0);
+    for (size_t count : {5, 6}) {
+        auto keys = CorrelatedSeeds::deal_pair_keys(1, count);
+        const std::vector<size_t> late = {2, 5};
+
+        // On-time shares alone still carry the seeds shared with the late parties
+        SimdBytes on_time(byte_count, 0);
+        SimdBytes corrected(byte_count, 0);
+        for (size_t party = 1; party <= count; ++party) {
+            if (std::find(late.begin(), late.end(), party) != late.end()) continue;
+            CorrelatedSeeds seeds(keys[party - 1], party, 1, count, seed_count);
+            SimdBytes share = seeds.expand(byte_count);
+            on_time ^= share;
+            share ^= seeds.expand_pairs(late, byte_count);
+            corrected ^= share;
+        }
+        ASSERT_NE(on_time.to_bytes(), zero_bytes) << "count " << count;
+        ASSERT_EQ(corrected.to_bytes(), zero_bytes) << "count " << count;
+
+        // A correction holds exactly the rounds against the listed partners
+        CorrelatedSeeds seeds(keys[0], 1, 1, count, seed_count);
+        ASSERT_EQ(seeds.expand_pairs({}, byte_count).to_bytes(), zero_bytes);
+        std::vector<size_t> everyone;
+        for (size_t party = 2; party <= count; ++party) everyone.push_back(party);
+        ASSERT_EQ(seeds.expand_pairs(everyone, byte_count).to_bytes(), seeds.expand(byte_count).to_bytes());
+    }
+}
+
+static std::vector<std::array<uint64_t, 2>> random_digests(std::mt19937_64& rng, size_t count) {
+    std::vector<std::array<uint64_t, 2>> digests(count);
+    for (auto& digest : digests) {
+        digest = {rng(), rng()};
+    }
+    return digests;
+}
+
+/* XOR of the three cells an element maps to */
+static std::vector<uint8_t> decode(const BinaryFuseFilter& filter, const uint8_t* cells,
+                                   const std::array<uint64_t, 2>& digest) {
+    const size_t width = filter.fingerprint_bytes();
+    std::vector<uint8_t> value(width, 0);
+    for (size_t position : filter.positions(digest)) {
+        for (size_t b = 0; b < width; ++b) value[b] ^= cells[position * width + b];
+    }
+    return value;
+}
+
+TEST(BinaryFuseFilterTest, MembersDecodeToTheirFingerprint) {
+    std::mt19937_64 rng(7);
+    for (size_t width : {1, 2, 4}) {
+        BinaryFuseFilter filter(500, width, 11);
+        auto members = random_digests(rng, 500);
+        std::vector<uint8_t> cells(filter.byte_size());
+        ASSERT_EQ(filter.encode(members, cells.data()), 0u);
+        std::vector<uint8_t> fingerprint(width);
+        for (const auto& digest : members) {
+            filter.fingerprint(digest, fingerprint.data());
+            ASSERT_EQ(decode(filter, cells.data(), digest), fingerprint) << "width " << width;
+        }
+        ASSERT_EQ(filter.encode(members, cells.data(), false), 0u);
+        for (const auto& digest : members) {
+            ASSERT_EQ(decode(filter, cells.data(), digest), std::vector<uint8_t>(width, 0)) << "width " << width;
+        }
+    }
+}
+
+TEST(BinaryFuseFilterTest, QuerierParityZeroesCommonElements) {
+    // Senders 1..party_count-1; odd and even numbers of non-querier senders
+    std::mt19937_64 rng(13);
+    const size_t set_size = 200, width = 2;
+    BinaryFuseFilter filter(set_size, width, 5);
+    for (size_t party_count : {4, 5, 6, 7}) {
+        auto common = random_digests(rng, set_size / 2);
+        std::vector<uint8_t> aggregate(filter.byte_size(), 0);
+        for (size_t id = 1; id < party_count; ++id) {
+            auto set = common;
+            auto unique = random_digests(rng, set_size - common.size());
+            set.insert(set.end(), unique.begin(), unique.end());
+            std::vector<uint8_t> cells(filter.byte_size());
+            ASSERT_EQ(filter.encode(set, cells.data(), fuse_encodes_fingerprints(id, party_count)), 0u);
+            for (size_t i = 0; i < cells.size(); ++i) aggregate[i] ^= cells[i];
+        }
+        for (const auto& digest : common) {
+            ASSERT_EQ(decode(filter, aggregate.data(), digest), std::vector<uint8_t>(width, 0))
+                << "party count " << party_count;
+        }
+    }
+}
+
+TEST(ShardLayoutTest, OwnerMatchesShardRanges) {
+    // Uneven splits, more shards than units, and an empty share
+    for (size_t shards : {1, 2, 3, 7, 16}) {
+        for (size_t units : {0, 1, 5, 64, 1001}) {
+            ShardLayout layout(shards, units, 3);
+            size_t covered = 0;
+            for (size_t shard = 0; shard < shards; ++shard) {
+                ASSERT_EQ(layout.first_unit(shard), covered);
+                for (size_t unit = covered; unit < covered + layout.unit_count(shard); ++unit) {
+                    ASSERT_EQ(layout.owner(unit), shard) << shards << " shards, " << units << " units";
+                }
+                ASSERT_EQ(layout.byte_begin(shard), covered * 3);
+                covered += layout.unit_count(shard);
+                ASSERT_EQ(layout.byte_end(shard), covered * 3);
+            }
+            ASSERT_EQ(covered, units);
+        }
+    }
+}
+
+TEST(ShareEpochServerTest, RestoreRejectsCorruptOrMismatchedSnapshot) {
+    char dir_template[] = "/tmp/snapshot_testXXXXXX";
+    ASSERT_NE(mkdtemp(dir_template), nullptr);
+    const std::string dir = dir_template;
+    ShareShape shape;
+    shape.encoding = "bloom/standard";
+    shape.bin_count = 256;
+    shape.probe_width = 2;
+    shape.hash_count = 7;
+    shape.set_size = 100;
+    shape.party_count = 5;
+
+    std::vector<uint8_t> bytes(shape.bin_count * shape.probe_width);
+    for (size_t i = 0; i < bytes.size(); ++i) bytes[i] = static_cast<uint8_t>(i * 31 + 7);
+    ShareEpochServer(dir, shape).publish(3, SimdBytes::from_bytes(bytes));
+
+    {
+        ShareEpochServer server(dir, shape);
+        ASSERT_TRUE(server.restore(true, false));
+        ASSERT_EQ(server.current()->epoch(), 3u);
+        ASSERT_EQ(std::vector<uint8_t>(server.current()->data(), server.current()->data() + server.current()->size()), bytes);
+    }
+    ShareShape other = shape;
+    other.probe_width = 1;
+    ASSERT_FALSE(ShareEpochServer(dir, other).restore(true, false));
+
+    // Flip one payload byte: only a verified restore notices
+    const std::string path = dir + "/aggregate_share.snap";
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(-1, std::ios::end);
+        char last = 0;
+        file.read(&last, 1);
+        file.seekp(-1, std::ios::end);
+        last ^= 1;
+        file.write(&last, 1);
+    }
+    ASSERT_FALSE(ShareEpochServer(dir, shape).restore(true, false));
+    ASSERT_TRUE(ShareEpochServer(dir, shape).restore(false, false));
+
+    std::remove(path.c_str());
+    std::remove(dir.c_str());
+}
+
+TEST(ByteStringArenaTest, KeysRoundTripAndFingerprintByContent) {
+    const std::vector<std::string> keys = {"alice@example.org", "", "bob", std::string("nul\0byte", 8), "alice@example.org"};
+    ByteStringArena arena;
+    arena.reserve(keys.size(), 64);
+    size_t byte_count = 0;
+    for (const auto& key : keys) {
+        arena.push_back(key);
+        byte_count += key.size();
+    }
+    ASSERT_EQ(arena.size(), keys.size());
+    ASSERT_EQ(arena.byte_size(), byte_count);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ASSERT_EQ(arena[i], keys[i]);
+    }
+    ASSERT_THROW(arena[keys.size()], std::out_of_range);
+
+    // Equal keys share a fingerprint; the 64-bit one is the prefix of the 128-bit one
+    const FingerprintKey key = ByteStringArena::derive_key("test context");
+    auto short_prints = arena.fingerprints64(key);
+    auto long_prints = arena.fingerprints128(key);
+    ASSERT_EQ(short_prints[0], short_prints[4]);
+    ASSERT_EQ(long_prints[0], long_prints[4]);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ASSERT_EQ(short_prints[i], long_prints[i][0]);
+        for (size_t j = 0; j < 4; ++j) {
+            if (i != j && keys[i] != keys[j]) ASSERT_NE(long_prints[i], long_prints[j]);
+        }
+    }
+    // Another context keys a different fingerprint
+    ASSERT_NE(arena.fingerprints64(ByteStringArena::derive_key("other context"))[0], short_prints[0]);
+}
+
+TEST(QueryEncodingTest, PackedQueryRoundTrips) {
+    std::vector<std::vector<size_t>> patterns;
+    for (size_t q = 0; q < 37; ++q) {
+        patterns.push_back({q, q * 1009 % 70001, 70000 - q, (q * 7919) % 65536, 1});
+    }
+    std::vector<uint8_t> message = encode_packed_query(patterns);
+    ASSERT_LT(message.size(), patterns.size() * patterns[0].size() * sizeof(size_t));
+    ASSERT_EQ(decode_packed_query(message), patterns);
+
+    ASSERT_TRUE(decode_packed_query(encode_packed_query({})).empty());
+    std::vector<std::vector<size_t>> wide = {{SIZE_MAX, 0}, {12345678901234ULL, SIZE_MAX >> 1}};
+    ASSERT_EQ(decode_packed_query(encode_packed_query(wide)), wide);
+}
+
+TEST(DeltaShareTest, ShareDeltaRoundTrips) {
+    ShareDelta delta;
+    delta.width = 3;
+    delta.bins = {0, 7, 4096, 65535};
+    for (size_t i = 0; i < delta.bins.size() * delta.width; ++i) {
+        delta.xor_bytes.push_back(static_cast<uint8_t>(i * 37 + 1));
+    }
+    ShareDelta decoded = ShareDelta::deserialize(delta.serialize());
+    ASSERT_EQ(decoded.width, delta.width);
+    ASSERT_EQ(decoded.bins, delta.bins);
+    ASSERT_EQ(decoded.xor_bytes, delta.xor_bytes);
+
+    ShareDelta empty = ShareDelta::deserialize(ShareDelta().serialize());
+    ASSERT_TRUE(empty.bins.empty());
+    ASSERT_TRUE(empty.xor_bytes.empty());
+
+    std::vector<uint8_t> truncated = delta.serialize();
+    truncated.pop_back();
+    ASSERT_THROW(ShareDelta::deserialize(truncated), std::runtime_error);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();